@@ -14,4 +14,17 @@ endif()
 
 if(DEFINED DYNAMIC_RENDERING AND DYNAMIC_RENDERING)
     add_compile_definitions(DYNAMIC_RENDERING)
-endif()
\ No newline at end of file
+endif()
+
+#json stage-1 scanner uses SSE2 by default on x86-64, AVX2 when this is set
+if(DEFINED JSON_AVX2 AND JSON_AVX2)
+    if(MSVC)
+        add_compile_options(/arch:AVX2)
+    else()
+        add_compile_options(-mavx2)
+    endif()
+endif()
+
+if(DEFINED JSON_FORCE_SCALAR AND JSON_FORCE_SCALAR)
+    add_compile_definitions(JSON_FORCE_SCALAR)
+endif()
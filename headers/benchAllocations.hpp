@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+// heap allocation counters shared by the benchmarks. linking source/benchAllocations.cpp replaces the global
+// operator new / delete with malloc / free versions that count every allocation
+
+struct AllocationCounts {
+	size_t count = 0;
+	size_t bytes = 0;
+};
+
+//allocations made by the process so far
+AllocationCounts allocationCounts();
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+#include "vertexIndex.hpp"
+
+// bounding volumes fitted to a mesh's vertices at load time, tighter than its Bounds for frustum culling, see
+// Scene::frustumCull. both are in the mesh's local space
+// the sphere is Ritter's ("An Efficient Bounding Sphere", Graphics Gems 1990) or the sphere around the axis aligned box,
+// whichever is smaller. the box is aligned to the principal axes of the vertices (eigenvectors of their covariance),
+// or to the mesh's own axes if that box is smaller, so a rotated, elongated mesh gets a box that follows it
+
+struct BoundingSphere {
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+};
+
+struct OrientedBounds {
+	glm::vec3 center = glm::vec3(0.0f);
+	glm::vec3 axes[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) }; //orthonormal
+	glm::vec3 halfExtents = glm::vec3(0.0f); //along each of axes, at least minHalfExtent
+};
+
+BoundingSphere fitBoundingSphere(const Vertex* vertices, uint32_t numVertices);
+
+//half extents under minHalfExtent are raised to it, like Bounds::fixZeroVolume
+OrientedBounds fitOrientedBounds(const Vertex* vertices, uint32_t numVertices, float minHalfExtent);
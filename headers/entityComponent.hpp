@@ -1,5 +1,6 @@
 #pragma once
 #include <unordered_map>
+#include <vector>
 #include <cassert>
 
 //TODO make macro to choose uint64_t for entity size instead ?
@@ -23,6 +24,9 @@ private:
 
 	entitySize_t flags = (0x0U | ENTITY_IS_ENABLED | ENTITY_IS_STATIC); //TODO is flag paramter necessary ?
 
+	struct RestoreTag {};
+	Entity(RestoreTag, entitySize_t _id, entitySize_t _flags) : id(_id), flags(_flags) {};
+
 public:
 	bool isEnabled() const;
 	bool isStatic() const;
@@ -45,6 +49,20 @@ public:
 	void setHasEnvironmentNode(bool onOff);
 
 	entitySize_t getID() const { return id; };
+	entitySize_t getFlags() const { return flags; };
+
+	//rebuilds an entity saved by the scene cache, does NOT allocate a new id, see reserveIDs
+	static Entity restore(entitySize_t _id, entitySize_t _flags) {
+		return Entity(RestoreTag{}, _id, _flags);
+	};
+
+	//allocates count consecutive ids without creating entities, returns the first one
+	static entitySize_t reserveIDs(uint32_t count) {
+		entitySize_t first = totalEntities;
+		currentEntities += count;
+		totalEntities += count;
+		return first;
+	};
 
 	Entity() {
 		if (!totalEntities) totalEntities = 0;
@@ -140,6 +158,20 @@ public:
 	std::vector<T>::iterator dataEnd() {
 		return _data.end();
 	}
+
+	//whole storage, used by the scene cache to save and restore every component at once
+	const std::vector<T>& data() const {
+		return _data;
+	}
+
+	const std::unordered_map<entitySize_t, uint32_t>& idxs() const {
+		return _idxs;
+	}
+
+	void restore(std::vector<T>&& data, std::unordered_map<entitySize_t, uint32_t>&& idxs) {
+		_data = std::move(data);
+		_idxs = std::move(idxs);
+	}
 };
 
 
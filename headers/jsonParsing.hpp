@@ -9,16 +9,17 @@
 #include <glm/vec3.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <string>
+#include <string_view>
+#include <span>
+#include <limits>
 #include <iostream>
+#include "utils.hpp"
 
 // uncomment to disable assert()
 // #define NDEBUG
 
 
 namespace {
-    const std::unordered_set<char> WHITESPACE = { ' ', '\n', '\r', '\t' };
-    const std::unordered_set<char> DIGITS = { '1', '2', '3', '4', '5', '6', '7', '8', '9', '0' };
-    const std::unordered_set<char> NUM_CHARS = { '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', 'e', 'E', '.' };
     const std::unordered_set<char> ESCAPES = { '"', '\\', '/', 'b', 'f', 'n', 'r', 't' };
     const std::unordered_set<char> HEX_DIGITS = { '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', 'a', 'b', 'c', 'd', 'e', 'f' };
 }
@@ -47,20 +48,20 @@ typedef struct JSONNumber_struct {
     bool negative;
     std::variant<int, size_t, float> val;
 
-    float toFloat() {
+    float toFloat() const {
         assert(std::holds_alternative<float>(val));
         return std::get<float>(val);
     }
-    size_t toSizeT() {
+    size_t toSizeT() const {
         assert(std::holds_alternative<size_t>(val));
         return std::get<size_t>(val);
     }
-    int toInt() {
+    int toInt() const {
         assert(std::holds_alternative<int>(val));
         return std::get<int>(val);
     }
 
-    float toFloatDestructive() {
+    float toFloatDestructive() const {
         if (std::holds_alternative<float>(val)) return std::get<float>(val);
         else if (std::holds_alternative<size_t>(val)) return static_cast<float>(std::get<size_t>(val));
         else if (std::holds_alternative<int>(val)) return static_cast<float>(std::get<int>(val));
@@ -71,7 +72,13 @@ typedef struct JSONNumber_struct {
 
 struct JSONValue;
 
-using Object = std::unordered_map<std::string, JSONValue>;
+//transparent so objects can be looked up with a string_view key without building a std::string
+struct JSONKeyHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+};
+
+using Object = std::unordered_map<std::string, JSONValue, JSONKeyHash, std::equal_to<>>;
 
 using Array = std::vector<JSONValue>;
 
@@ -88,23 +95,24 @@ using Value = struct JSONValue : std::variant<
 
     JSONDataType type = MONOSTATE;
 
-    Object toObject() {
+    //all accessors borrow from the value, copy explicitly if the result must outlive it
+    const Object& toObject() const {
         return std::get<Object>(*this);
     }
 
-    Array toArray() {
+    const Array& toArray() const {
         return std::get<Array>(*this);
     }
 
-    Number toNumber() {
+    const Number& toNumber() const {
         return std::get<Number>(*this);
     }
 
-    const std::string toString() {
+    std::string_view toString() const {
         return std::get<std::string>(*this);
     }
 
-    void printType() {
+    void printType() const {
         std::cout << JSONDataTypeStrings.at(type);
     }
 
@@ -115,10 +123,99 @@ using Value = struct JSONValue : std::variant<
 
 };
 
+// ================================================================================================
+// TAPE : flat alternative to the Value tree, one contiguous token array with no per-object maps
+// ================================================================================================
+
+//keys and strings are views into the parser's file buffer, so the parser must outlive the tape
+struct TapeToken {
+    JSONDataType type = MONOSTATE;
+    uint32_t end = 0; //tape idx one past the last token of this value (own idx + 1 for non-containers)
+    uint32_t size = 0; //number of members / elements for OBJECT / ARRAY
+    std::string_view key{}; //key of this value if it is an object member, empty otherwise
+    std::string_view str{}; //raw contents of STRING values, escapes are not decoded
+    Number number{};
+    bool boolean = false;
+    bool floatArray = false; //ARRAY of only numbers exact as floats, elements are in JSONTape::floats instead of tokens
+    uint32_t floatsOffset = 0;
+};
+
+struct TapeRef;
+
+struct JSONTape {
+    std::vector<TapeToken> tokens{};
+    std::vector<float> floats{}; //elements of every numeric array, see TapeToken::floatArray
+
+    TapeRef root() const;
+};
+
+//non-owning handle to a value in a JSONTape, cheap to copy and pass by value
+struct TapeRef {
+    const JSONTape* tape = nullptr;
+    uint32_t idx = 0;
+
+    bool valid() const { return tape != nullptr; }
+    const TapeToken& token() const { return tape->tokens[idx]; }
+    JSONDataType type() const { return token().type; }
+    uint32_t size() const { return token().size; }
+    std::string_view key() const { return token().key; }
+
+    //linear scan over members, returns invalid ref if key is not present
+    TapeRef find(std::string_view keyName) const;
+    bool contains(std::string_view keyName) const { return find(keyName).valid(); }
+    TapeRef at(std::string_view keyName) const;
+    TapeRef operator[](uint32_t elementIdx) const;
+
+    Number toNumber() const { return token().number; }
+    std::string_view toString() const { return token().str; }
+    bool toBool() const { return token().boolean; }
+    bool isFloatArray() const { return token().floatArray; }
+    std::span<const float> toFloats() const { return std::span<const float>(tape->floats).subspan(token().floatsOffset, token().size); }
+    //elements of a numeric array as floats whether or not they are in the float storage, out must hold size()
+    void copyFloats(float* out) const;
+
+    //iterates over members of an object or elements of an array, use toFloats() for numeric arrays
+    struct iterator {
+        const JSONTape* tape = nullptr;
+        uint32_t idx = 0;
+
+        TapeRef operator*() const { return TapeRef{ tape, idx }; }
+        iterator& operator++() { idx = tape->tokens[idx].end; return *this; }
+        bool operator!=(const iterator& other) const { return idx != other.idx; }
+    };
+    iterator begin() const { return iterator{ tape, idx + 1 }; }
+    iterator end() const { return iterator{ tape, token().end }; }
+};
+
+//push-style parse events, override only the ones needed, see JSONParser::parseEvents
+//strings and keys are views into the parser's file buffer
+struct JSONHandler {
+    virtual ~JSONHandler() = default;
+
+    virtual void startObject() {}
+    virtual void key(std::string_view /*keyName*/) {}
+    virtual void endObject(uint32_t /*members*/) {}
+    virtual void startArray() {}
+    virtual void endArray(uint32_t /*elements*/) {}
+    virtual void number(const Number& /*number*/) {}
+    virtual void string(std::string_view /*str*/) {}
+    virtual void boolean(bool /*boolean*/) {}
+    virtual void null() {}
+};
+
 class JSONParser {
     size_t i = 0;
-    std::string file;
+    //file is a view of input, which is memory mapped when possible
+    MappedFile input{};
+    std::string_view file{};
     size_t fileSize = 0;
+    //stage-1 output, see jsonStructural.hpp
+    //structurals views ownStructurals, or the parent's index for parsers made by splitArray
+    std::vector<uint32_t> ownStructurals{};
+    std::span<const uint32_t> structurals{};
+    size_t structuralIdx = 0;
+    //offset of the separator ending this parser's range of the current array, see splitArray
+    size_t rangeEnd = std::numeric_limits<size_t>::max();
 
     bool readJSONFile(std::string filename);
 
@@ -126,47 +223,137 @@ class JSONParser {
 
     char at(int j);
 
-    //return true if did skip any whitespace
+    //moves i to the next structural index at or after i
     void skipWhiteSpace();
 
     Object parseObject();
 
     Array parseArray();
 
+    //moves i past the number at i and sets its type and sign, checking it against the JSON number grammar
+    //shared by parseNumber and parseFloatArray so both accept the same numbers
+    void scanNumber(Number& number);
+
     Number parseNumber();
 
     std::string parseString();
 
+    //same validation as parseString, but returns a view into file instead of a copy
+    std::string_view parseStringView();
+
     bool parseBool();
 
     std::nullptr_t parseNull();
 
+    //i is on the first element of an array, appends every element to floats and stops on the closing ']'
+    //returns false and rewinds if any element is not a number, or with exactIntegers if an integer element is too
+    //large for a float to hold exactly
+    bool parseFloatArray(std::vector<float>& floats, bool exactIntegers = false);
+
     Value parseValue();
 
+    void parseTapeValue(JSONTape& tape, std::string_view key);
+
+    void parseEventValue(JSONHandler& handler);
+
 public:
     JSONParser(std::string _filename, bool* fileGood);
 
+    //parses a document already in memory, buffer must outlive the parser
+    explicit JSONParser(std::string_view buffer);
+
     JSONParser();
 
     Value parse();
+
+    //parse into a flat tape instead of a Value tree, see JSONTape
+    JSONTape parseTape();
+
+    //walk the whole document calling handler for every value, nothing is stored
+    void parseEvents(JSONHandler& handler);
+
+    //streaming over a top-level array one element at a time, so callers can drop each element's
+    //storage before the next one is parsed instead of holding the whole document
+    //consumes the opening '[', returns false if the next value is not an array
+    bool beginArray();
+
+    //moves past the separator onto the next element of the current array, false once the closing ']' is consumed
+    bool nextElement();
+
+    //parse the next element into tape (cleared first), returns false once the closing ']' is reached
+    bool nextElement(JSONTape& tape);
+
+    //push the next element's events to handler, returns false once the closing ']' is reached
+    bool nextElement(JSONHandler& handler);
+
+    //splits the remaining elements of the current array into at most maxRanges contiguous ranges of roughly equal
+    //byte size, by walking the structural index only. each returned parser iterates one range with nextElement and
+    //can be used on its own thread, they view this parser's buffers so must not outlive it
+    //this parser is left on the closing ']', so its next nextElement returns false
+    std::vector<JSONParser> splitArray(size_t maxRanges);
+
+    //cursor API for decoders that read values straight into their own types, see s72Schema.hpp
+    //consumes the opening '{', returns false if the next value is not an object
+    bool beginObject();
+
+    //reads the next member's key and moves onto its value, false once the closing '}' is consumed
+    bool nextMember(std::string_view& key);
+
+    JSONDataType peekType();
+
+    Number readNumber();
+
+    std::string_view readString();
+
+    bool readBool();
+
+    //reads a numeric array, returns false (leaving the cursor on the array) if it is not one
+    bool readFloats(std::vector<float>& floats);
+
+    //reads a numeric array of exactly count elements
+    bool readFloats(float* floats, size_t count);
+
+    //skips the next value by walking the structural index, nothing inside it is parsed
+    void skipValue();
+
+    //value of a string member of the next object without moving the cursor, empty if it is not present
+    std::string_view peekMemberString(std::string_view key);
 };
 
 struct JSONUtils {
-    static Value getVal(const Object& obj, std::string keyName, JSONDataType type, bool CHECK_VALIDITY = false);
+    //DOM accessors return references / views into JSONObj, which must outlive them
+    static const Value& getVal(const Object& obj, std::string_view keyName, JSONDataType type, bool CHECK_VALIDITY = false);
 
-    static std::string getName(const Object& JSONObj, bool CHECK_VALIDITY = false);
+    static std::string_view getName(const Object& JSONObj, bool CHECK_VALIDITY = false);
 
-    static void getFloat3(Array arrVal, float* A, float* B, float* C);
+    static void getFloat3(const Array& arrVal, float* A, float* B, float* C);
 
-    static std::vector<size_t> getIndices(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY = false);
+    static std::vector<size_t> getIndices(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
 
-    static std::vector<std::string> getIndicesNames(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY = false);
+    static std::vector<std::string_view> getIndicesNames(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
 
-    static std::vector<float> getFloats(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY = false);
+    static std::vector<float> getFloats(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
 
-    static glm::vec3 getVec3(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY = false);
+    static glm::vec3 getVec3(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
 
     //static glm::vec4 getVec4(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY = false);
 
-    static glm::quat getQuat(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY = false);
+    static glm::quat getQuat(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
+
+    //tape overloads, none of these copy keys or strings out of the file buffer
+    static TapeRef getVal(TapeRef obj, std::string_view keyName, JSONDataType type, bool CHECK_VALIDITY = false);
+
+    static std::string_view getName(TapeRef JSONObj, bool CHECK_VALIDITY = false);
+
+    static void getFloat3(TapeRef arrVal, float* A, float* B, float* C);
+
+    static std::vector<size_t> getIndices(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
+
+    static std::vector<std::string_view> getIndicesNames(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
+
+    static std::vector<float> getFloats(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
+
+    static glm::vec3 getVec3(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
+
+    static glm::quat getQuat(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY = false);
 };
\ No newline at end of file
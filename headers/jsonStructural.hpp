@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// stage-1 of the json parser, in the style of simdjson (https://arxiv.org/abs/1902.08318)
+// uses AVX2 if compiled with it (cmake -DJSON_AVX2=ON), SSE2 on any x86-64 build, and a scalar fallback elsewhere
+// define JSON_FORCE_SCALAR to disable the SIMD paths
+
+enum JSONCharClass : uint8_t {
+    JSON_OP_CHAR = (0x1U << 0), // { } [ ] : ,
+    JSON_WHITESPACE_CHAR = (0x1U << 1),
+    JSON_QUOTE_CHAR = (0x1U << 2),
+    JSON_BACKSLASH_CHAR = (0x1U << 3),
+    JSON_DIGIT_CHAR = (0x1U << 4),
+    JSON_NUM_CHAR = (0x1U << 5) // digits, - + . e E
+};
+
+constexpr std::array<uint8_t, 256> makeJSONCharClasses() {
+    std::array<uint8_t, 256> classes{};
+    for (unsigned char c : { '{', '}', '[', ']', ':', ',' }) classes[c] |= JSON_OP_CHAR;
+    for (unsigned char c : { ' ', '\n', '\r', '\t' }) classes[c] |= JSON_WHITESPACE_CHAR;
+    classes[static_cast<unsigned char>('"')] |= JSON_QUOTE_CHAR;
+    classes[static_cast<unsigned char>('\\')] |= JSON_BACKSLASH_CHAR;
+    for (unsigned char c = '0'; c <= '9'; c++) classes[c] |= (JSON_DIGIT_CHAR | JSON_NUM_CHAR);
+    for (unsigned char c : { '-', '+', '.', 'e', 'E' }) classes[c] |= JSON_NUM_CHAR;
+    return classes;
+}
+
+inline constexpr std::array<uint8_t, 256> JSON_CHAR_CLASSES = makeJSONCharClasses();
+
+//charClasses may be several JSONCharClass or'd together
+inline bool isJSONCharClass(char c, uint8_t charClasses) {
+    return JSON_CHAR_CLASSES[static_cast<unsigned char>(c)] & charClasses;
+}
+
+//fills structurals with the offset of every { } [ ] : , and every value start (quote, digit, -, t, f, n) that is not
+//inside a string, in increasing order, followed by a sentinel equal to size
+void findStructurals(const char* data, size_t size, std::vector<uint32_t>& structurals);
@@ -1,8 +1,13 @@
 #pragma once
 #include "parameters.hpp"
 #include "vertexIndex.hpp"
-#include "jsonParsing.hpp"
+#include "s72Schema.hpp"
+#include "vertexCache.hpp"
+#include "stripify.hpp"
+#include "simplify.hpp"
+#include "boundingVolume.hpp"
 #include <array>
+#include <algorithm>
 
 struct Bounds {
 	//glm::vec3 min = glm::vec3(0.0f);
@@ -31,13 +36,84 @@ struct Bounds {
 	void fixZeroVolume();
 };
 
+//cluster of a mesh's triangles, culled on its own with --cluster, see buildMeshlets and Scene::drawScene
+//all in the mesh's local space
+struct Meshlet {
+	uint32_t firstIndex = 0; //offset from the mesh's indexOffset
+	uint32_t numIndices = 0;
+	Bounds bounds = Bounds();
+	//bounding sphere
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+	//normal cone, every triangle of the meshlet faces away from a viewer at eye when
+	//dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius
+	glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+	float coneCutoff = 1.0f; //sine of the cone's half angle, 1 never culls
+
+	inline bool backfacing(glm::vec3 eye) const {
+		glm::vec3 toCenter = center - eye;
+		return glm::dot(toCenter, coneAxis) >= coneCutoff * glm::length(toCenter) + radius;
+	}
+};
+
+//simplified version of a mesh drawn in its place when it is small on screen, see simplifyMesh and Scene::drawScene
+struct MeshLod {
+	uint32_t firstIndex = 0; //offset from the mesh's indexOffset, past its full detail indices
+	uint32_t numIndices = 0;
+	float error = 0.0f; //furthest the simplification moved the surface, in the mesh's units
+};
+
+//what the optional passes of loadMeshData did to one or more meshes
+struct MeshLoadReport {
+	VertexCacheReport vertexCache{}; //OPTIMIZE_VERTEX_CACHE
+	StripifyStats strips{}; //STRIPIFY
+	SimplifyStats lods{}; //LOD_LEVELS
+
+	MeshLoadReport& operator+=(const MeshLoadReport& other) {
+		vertexCache += other.vertexCache;
+		strips += other.strips;
+		lods += other.lods;
+		return *this;
+	}
+};
+
+//number of vertices / indices loadMeshData writes for one mesh
+struct MeshSize {
+	uint32_t vertices = 0;
+	uint32_t indices = 0;
+};
+
+//vertices and indices of one mesh before they are appended to the global buffers, indices are local to vertices
+struct MeshStaging {
+	std::vector<Vertex> vertices{};
+	std::vector<Index> indices{};
+	std::vector<Meshlet> meshlets{}; //with CLUSTER, derived from vertices and indices
+
+	//XXH64 of vertices then indices, meshes with byte-identical staging share one range of the global buffers
+	uint64_t hash() const;
+	bool sameBytes(const MeshStaging& other) const;
+};
+
 //TODO put in own mesh.hpp files
 struct Mesh {
 	Bounds bounds = Bounds();
+	//tighter than bounds, frustum culling tests the sphere first and the box only if the sphere straddles a plane
+	BoundingSphere boundingSphere{};
+	OrientedBounds orientedBounds{};
 	uint32_t indexOffset = 0; //offset into index buffer
 	uint32_t numIndices = 0; //num indices
+	uint32_t vertexOffset = 0; //offset into vertex buffer of the mesh's first vertex, its indices are local to it and drawn with it as the vertexOffset
 	uint32_t material = 0; //idx into material array
 	uint32_t debugVertexOffset = 0; //offset from the START of TEMP_DEBUG_VERTICES
+	uint32_t meshletOffset = 0; //offset into Scene::meshlets, set by the scene once the mesh's meshlets are appended
+	uint32_t numMeshlets = 0; //0 without CLUSTER, or if the mesh couldn't be clustered
+	//LOD 1 onwards, each with about half the triangles of the one before, LOD 0 is indexOffset / numIndices
+	static inline constexpr uint32_t MAX_LODS = 4; //including LOD 0
+	std::array<MeshLod, MAX_LODS - 1> lods{};
+	uint32_t numLods = 0; //0 without LOD_LEVELS, or if the mesh couldn't be simplified
+	//LOD n may move the surface by up to LOD_ERROR * 2^(n - 1) of the mesh's bounds diagonal, see Scene::LOD_SCREEN_SIZE
+	static inline constexpr float LOD_ERROR = 0.01f;
+	bool resident = true; //false until a streamed mesh's data is in the global buffers, see Scene::updateStreaming
 
 	// since the indices for each debug bounds will be the same minus a fixed offset
 	// will keep track of the index to the start of the tempDebugVertices part of the vertex buffer
@@ -60,7 +136,36 @@ struct Mesh {
 																					 PRIMITIVE_RESTART_IDX, 2, 6,
 															                         PRIMITIVE_RESTART_IDX, 1, 5 };
 
-	//loads mesh data in place and copies vertex data into vertex buffer
-	void loadMeshData(const std::string filename, const Object& JSONObj, const ModeConstantParameters& parameters);
-	void toIndexed(const std::vector<Vertex>& srcBuffer);
+	//LOD_LEVELS clamped to [1, MAX_LODS]
+	static inline uint32_t lodLevels(const ModeConstantParameters& parameters) { return static_cast<uint32_t>(std::clamp(parameters.LOD_LEVELS, 1, static_cast<int>(MAX_LODS))); }
+	//indices of every LOD, the size of the mesh's range of the index buffer
+	inline uint32_t totalIndices() const { return numLods ? lods[numLods - 1].firstIndex + lods[numLods - 1].numIndices : numIndices; }
+
+	//meshes are loaded in two passes so the memory they are read into can be allocated once up front
+	//sizing pass, reads no vertex data. indices is exact, vertices is exact for indexed meshes and an upper bound
+	//otherwise since toIndexed drops duplicate vertices, and with STRIPIFY or LOD_LEVELS indices is the most they can write
+	static MeshSize plannedSize(const S72Mesh& s72Mesh, const ModeConstantParameters& parameters);
+	//fill pass, reads the mesh files straight into vertexOut / indexOut, which must hold size, indices are local to
+	//vertexOut. fills in numIndices, numMeshlets, lods and the bounding volumes and returns the number of vertices written, totalIndices() are
+	//written. doesn't touch the global buffers so different meshes can be loaded on different threads
+	//with OPTIMIZE_VERTEX_CACHE the mesh is reordered for the vertex cache, with LOD_LEVELS simplified LODs are written
+	//after its indices, with CLUSTER and meshletsOut given it (LOD 0) is split into meshlets that are appended to
+	//meshletsOut, with STRIPIFY its indices (each meshlet's and LOD's on their own) are turned into strips, and if
+	//given, report is added to
+	uint32_t loadMeshData(const std::string& filename, const S72Mesh& s72Mesh, const ModeConstantParameters& parameters, Vertex* vertexOut, Index* indexOut, MeshSize size,
+		std::vector<Meshlet>* meshletsOut = nullptr, MeshLoadReport* report = nullptr);
+	//both passes into staging
+	void loadMeshData(const std::string& filename, const S72Mesh& s72Mesh, const ModeConstantParameters& parameters, MeshStaging& staging);
+	//dedups the count vertices in place, writing count indices, returns the number of vertices left, see weldVertices
+	static uint32_t toIndexed(Vertex* meshVertices, uint32_t count, Index* indicesOut, size_t numThreads = 1);
+	//copies staged data onto the end of the global buffers and sets indexOffset and vertexOffset
+	void appendMeshData(const MeshStaging& staging);
+	//uses geometry other already appended to the global buffers instead of appending its own
+	void shareMeshData(const Mesh& other);
+
+	//every field of s72Mesh that decides what loadMeshData reads, meshes with equal keys load identical geometry
+	static std::string geometryKey(const S72Mesh& s72Mesh);
+
+	//first of the mesh search paths for filename that exists, empty if there is none
+	static std::string findFile(const std::string& filename);
 };
\ No newline at end of file
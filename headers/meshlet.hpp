@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+
+// meshlet clustering of indexed triangle lists (--cluster)
+// meshlets are grown greedily from the first unused triangle, each step taking the unused triangle next to the
+// meshlet that shares the most vertices with it, until no neighbour fits in the vertex / triangle limits. a meshlet
+// that runs out of neighbours while still under half full carries on from the next unused triangle in index order
+// the mesh's triangles are reordered so each meshlet's are contiguous, so a run of visible meshlets is still one
+// indexed draw, and every meshlet gets bounds, a bounding sphere and a normal cone for culling
+
+//most triangles in a meshlet of maxVertices vertices, about what a regular grid patch of that many vertices holds
+inline uint32_t meshletMaxTriangles(uint32_t maxVertices) { return maxVertices > 4 ? 2 * maxVertices - 4 : 1; }
+
+//indices is a triangle list into the numVertices vertices, its triangles are reordered in place, each keeping its
+//winding, and the meshlets are appended to meshletsOut. maxVertices is clamped to at least 3
+void buildMeshlets(const Vertex* vertices, uint32_t numVertices, Index* indices, uint32_t numIndices, uint32_t maxVertices, std::vector<Meshlet>& meshletsOut);
@@ -9,12 +9,20 @@ struct ModeConstantParameters {
 	bool FRUSTUM_CULLING = false;
 	bool OCCLUSION_CULLING = false;
 	bool STRIPIFY = false;
-	bool CLUSTER = false;
-	bool CLUSTER_SIZE = 64;
+	bool CLUSTER = false; //split meshes into meshlets that are culled on their own, see meshlet.hpp
+	int CLUSTER_SIZE = 64; //most vertices in a meshlet
+	int LOD_LEVELS = 1; //LODs per mesh including the mesh itself, up to Mesh::MAX_LODS, see simplifyMesh
 	bool DEBUG = false;
 	int DEBUG_LEVEL = 0;
 	bool PRINT_DEBUG_OUTPUT = false;
 	bool ENABLE_DEBUG_VIEW = false; //draw mesh bounds
+	int LOAD_THREADS = 0; //threads used to parse the scene file and load its meshes, 0 is one per hardware thread, 1 is serial
+	bool STREAM_MESHES = false; //load meshes on background threads after the scene graph, drawing each once it arrives
+	bool SCENE_CACHE = true; //load from / write a {scene}.s72b binary cache next to the scene file
+	bool HOT_RELOAD = false; //watch the scene and mesh files and patch the loaded scene in place when they are re-exported
+	bool OPTIMIZE_VERTEX_CACHE = false; //reorder triangles then vertices of loaded meshes for the post-transform cache and vertex fetch
+	std::string VERTEX_LAYOUT = "full"; //layout vertices are uploaded in, see vertexLayouts
+	bool SPLIT_POSITIONS = false; //upload positions as their own vertex stream, see splitVertexPositions
 	ModeConstantParameters() = default;
 };
 
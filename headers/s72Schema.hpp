@@ -0,0 +1,344 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <tuple>
+#include <vector>
+#include <string_view>
+#include <type_traits>
+#include <cstdint>
+#include <limits>
+
+#include "jsonParsing.hpp"
+
+// typed .s72 objects and their compile-time schemas, decoded straight from the parser cursor with no DOM or tape
+// every field table is perfect hashed at compile time, so finding a field is one hash and one key compare
+// strings are views into the parser's file buffer
+
+namespace S72 {
+	//FNV-1a, seeded so a collision free seed can be searched for per table
+	constexpr uint32_t keyHash(std::string_view key, uint32_t seed) {
+		uint32_t hash = 2166136261u ^ seed;
+		for (char c : key) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 16777619u;
+		}
+		//low bits of FNV only depend on the low bits of the seed, fold the high bits down so every seed gives a new table
+		return hash ^ (hash >> 16);
+	}
+
+	template<size_t N>
+	struct KeyTable {
+		static constexpr size_t SLOTS = std::bit_ceil(N * 2);
+		static constexpr uint32_t NO_SEED = std::numeric_limits<uint32_t>::max();
+
+		std::array<std::string_view, N> keys{};
+		uint32_t seed = NO_SEED;
+		std::array<uint8_t, SLOTS> slots{}; //key idx + 1, 0 if empty
+
+		constexpr KeyTable(const std::array<std::string_view, N>& _keys) : keys(_keys) {
+			static_assert(N < std::numeric_limits<uint8_t>::max());
+			for (uint32_t trySeed = 0; trySeed < 10000 && seed == NO_SEED; trySeed++) {
+				std::array<uint8_t, SLOTS> trySlots{};
+				bool collision = false;
+				for (size_t k = 0; k < N && !collision; k++) {
+					uint8_t& slot = trySlots[keyHash(keys[k], trySeed) & (SLOTS - 1)];
+					collision = slot != 0;
+					slot = static_cast<uint8_t>(k + 1);
+				}
+				if (!collision) {
+					seed = trySeed;
+					slots = trySlots;
+				}
+			}
+		}
+
+		//idx of key in keys, N if it is not in the table
+		constexpr size_t find(std::string_view key) const {
+			uint8_t slot = slots[keyHash(key, seed) & (SLOTS - 1)];
+			return (slot != 0 && keys[slot - 1] == key) ? slot - 1 : N;
+		}
+	};
+
+	template<typename T, typename M>
+	struct Field {
+		std::string_view key;
+		M T::* member;
+	};
+
+	template<typename T, typename M>
+	constexpr Field<T, M> field(std::string_view key, M T::* member) {
+		return Field<T, M>{ key, member };
+	}
+
+	//value is skipped, only its presence is recorded
+	struct Ignored {};
+
+	template<typename T>
+	struct Schema;
+
+	template<typename T>
+	constexpr auto makeKeyTable() {
+		return std::apply([](const auto&... fields) {
+			return KeyTable<sizeof...(fields)>(std::array<std::string_view, sizeof...(fields)>{ fields.key... });
+			}, Schema<T>::fields);
+	}
+
+	template<typename T>
+	inline constexpr auto KEYS = makeKeyTable<T>();
+
+	//bit of a field in T::present, key is checked at compile time
+	template<typename T>
+	consteval uint64_t fieldBit(std::string_view key) {
+		size_t idx = KEYS<T>.find(key);
+		if (idx == KEYS<T>.keys.size()) throw "key is not part of the schema";
+		return uint64_t(1) << idx;
+	}
+
+	template<typename T>
+	concept HasSchema = requires { Schema<T>::fields; };
+
+	//vector of schema objects, stored in the file as an object of named objects
+	template<typename M>
+	concept KeyedList = requires { typename M::value_type; } && HasSchema<typename M::value_type>;
+}
+
+// ================================================================================================
+// OBJECTS
+// ================================================================================================
+
+struct S72Attribute {
+	std::string_view name{}; //key of the attribute in the mesh's attributes object
+	std::string_view src{};
+	uint32_t offset = 0;
+	uint32_t stride = 0;
+	std::string_view format{};
+};
+
+struct S72Indices {
+	std::string_view src{};
+	uint32_t offset = 0;
+	std::string_view format{};
+};
+
+struct S72Mesh {
+	std::string_view name{};
+	std::string_view topology{};
+	uint32_t count = 0;
+	std::vector<S72Attribute> attributes{}; //in file order
+	S72Indices indices{};
+	std::string_view material{};
+	uint64_t present = 0;
+};
+
+struct S72Node {
+	std::string_view name{};
+	glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f);
+	std::vector<std::string_view> children{};
+	std::string_view mesh{};
+	std::string_view camera{};
+	std::string_view environment{};
+	std::string_view light{};
+	uint64_t present = 0;
+};
+
+struct S72Perspective {
+	float aspect = 0.0f;
+	float vfov = 0.0f;
+	float nearPlane = 0.0f;
+	float farPlane = 0.0f;
+	uint64_t present = 0;
+};
+
+struct S72Camera {
+	std::string_view name{};
+	S72Perspective perspective{};
+	uint64_t present = 0;
+};
+
+struct S72Driver {
+	std::string_view name{};
+	std::string_view node{};
+	std::string_view channel{};
+	std::vector<float> times{};
+	std::vector<float> values{};
+	std::string_view interpolation{};
+	uint64_t present = 0;
+};
+
+struct S72Scene {
+	std::string_view name{};
+	std::vector<std::string_view> roots{};
+	uint64_t present = 0;
+};
+
+struct S72Material {
+	std::string_view name{};
+	S72::Ignored pbr{};
+	S72::Ignored lambertian{};
+	S72::Ignored mirror{};
+	S72::Ignored environment{};
+	uint64_t present = 0;
+};
+
+struct S72Environment {
+	std::string_view name{};
+	uint64_t present = 0;
+};
+
+struct S72Light {
+	std::string_view name{};
+	uint64_t present = 0;
+};
+
+namespace S72 {
+	template<> struct Schema<S72Attribute> {
+		static constexpr auto fields = std::make_tuple(
+			field("src", &S72Attribute::src), field("offset", &S72Attribute::offset),
+			field("stride", &S72Attribute::stride), field("format", &S72Attribute::format));
+	};
+	template<> struct Schema<S72Indices> {
+		static constexpr auto fields = std::make_tuple(
+			field("src", &S72Indices::src), field("offset", &S72Indices::offset), field("format", &S72Indices::format));
+	};
+	template<> struct Schema<S72Mesh> {
+		static constexpr auto fields = std::make_tuple(
+			field("name", &S72Mesh::name), field("topology", &S72Mesh::topology), field("count", &S72Mesh::count),
+			field("attributes", &S72Mesh::attributes), field("indices", &S72Mesh::indices), field("material", &S72Mesh::material));
+	};
+	template<> struct Schema<S72Node> {
+		static constexpr auto fields = std::make_tuple(
+			field("name", &S72Node::name), field("translation", &S72Node::translation), field("rotation", &S72Node::rotation),
+			field("scale", &S72Node::scale), field("children", &S72Node::children), field("mesh", &S72Node::mesh),
+			field("camera", &S72Node::camera), field("environment", &S72Node::environment), field("light", &S72Node::light));
+	};
+	template<> struct Schema<S72Perspective> {
+		static constexpr auto fields = std::make_tuple(
+			field("aspect", &S72Perspective::aspect), field("vfov", &S72Perspective::vfov),
+			field("near", &S72Perspective::nearPlane), field("far", &S72Perspective::farPlane));
+	};
+	template<> struct Schema<S72Camera> {
+		static constexpr auto fields = std::make_tuple(
+			field("name", &S72Camera::name), field("perspective", &S72Camera::perspective));
+	};
+	template<> struct Schema<S72Driver> {
+		static constexpr auto fields = std::make_tuple(
+			field("name", &S72Driver::name), field("node", &S72Driver::node), field("channel", &S72Driver::channel),
+			field("times", &S72Driver::times), field("values", &S72Driver::values), field("interpolation", &S72Driver::interpolation));
+	};
+	template<> struct Schema<S72Scene> {
+		static constexpr auto fields = std::make_tuple(
+			field("name", &S72Scene::name), field("roots", &S72Scene::roots));
+	};
+	template<> struct Schema<S72Material> {
+		static constexpr auto fields = std::make_tuple(
+			field("name", &S72Material::name), field("pbr", &S72Material::pbr), field("lambertian", &S72Material::lambertian),
+			field("mirror", &S72Material::mirror), field("environment", &S72Material::environment));
+	};
+	template<> struct Schema<S72Environment> {
+		static constexpr auto fields = std::make_tuple(field("name", &S72Environment::name));
+	};
+	template<> struct Schema<S72Light> {
+		static constexpr auto fields = std::make_tuple(field("name", &S72Light::name));
+	};
+
+	//values of "type", in the same order as Scene::objType so the idx can be cast directly
+	inline constexpr KeyTable<9> OBJECT_TYPES({ "SCENE", "NODE", "MESH", "CAMERA", "DRIVER", "DATA", "MATERIAL", "ENVIRONMENT", "LIGHT" });
+	//attribute names, in the same order as AttributeSemantic
+	enum AttributeSemantic : uint8_t { POSITION, NORMAL, TANGENT, TEXCOORD, COLOR, UNKNOWN_ATTRIBUTE };
+	inline constexpr KeyTable<5> ATTRIBUTE_NAMES({ "POSITION", "NORMAL", "TANGENT", "TEXCOORD", "COLOR" });
+	inline constexpr KeyTable<5> ATTRIBUTE_FORMATS({ "R32G32B32_SFLOAT", "R32G32B32A32_SFLOAT", "R32G32_SFLOAT", "R32_SFLOAT", "R8G8B8A8_UNORM" });
+	inline constexpr std::array<uint32_t, 5> ATTRIBUTE_FORMAT_SIZES = { 12, 16, 8, 4, 4 };
+	inline constexpr KeyTable<3> INDEX_FORMATS({ "UINT8", "UINT16", "UINT32" });
+	inline constexpr std::array<uint32_t, 3> INDEX_FORMAT_SIZES = { 1, 2, 4 };
+	enum DriverChannel : uint8_t { TRANSLATION_CHANNEL, SCALE_CHANNEL, ROTATION_CHANNEL };
+	inline constexpr KeyTable<3> DRIVER_CHANNELS({ "translation", "scale", "rotation" });
+	enum DriverInterpolation : uint8_t { STEP, LINEAR, SLERP };
+	inline constexpr KeyTable<3> DRIVER_INTERPOLATIONS({ "STEP", "LINEAR", "SLERP" });
+
+	template<typename T>
+	void decode(JSONParser& parser, T& object);
+
+	template<typename M>
+	void decodeValue(JSONParser& parser, M& value) {
+		if constexpr (std::is_same_v<M, std::string_view>) {
+			value = parser.readString();
+		}
+		else if constexpr (std::is_same_v<M, float>) {
+			value = parser.readNumber().toFloatDestructive();
+		}
+		else if constexpr (std::is_same_v<M, uint32_t>) {
+			value = static_cast<uint32_t>(parser.readNumber().toSizeT());
+		}
+		else if constexpr (std::is_same_v<M, bool>) {
+			value = parser.readBool();
+		}
+		else if constexpr (std::is_same_v<M, glm::vec3>) {
+			float xyz[3];
+			parser.readFloats(xyz, 3);
+			value = glm::vec3(xyz[0], xyz[1], xyz[2]);
+		}
+		else if constexpr (std::is_same_v<M, glm::quat>) {
+			float xyzw[4];
+			parser.readFloats(xyzw, 4);
+			value = glm::quat(xyzw[3], xyzw[0], xyzw[1], xyzw[2]);
+		}
+		else if constexpr (std::is_same_v<M, std::vector<float>>) {
+			value.clear();
+			[[maybe_unused]]
+			bool isNumeric = parser.readFloats(value);
+			assert(isNumeric);
+		}
+		else if constexpr (std::is_same_v<M, std::vector<std::string_view>>) {
+			value.clear();
+			parser.beginArray();
+			while (parser.nextElement()) value.emplace_back(parser.readString());
+		}
+		else if constexpr (std::is_same_v<M, Ignored>) {
+			parser.skipValue();
+		}
+		else if constexpr (KeyedList<M>) {
+			//object of named objects (mesh attributes), each member's key becomes its name
+			value.clear();
+			parser.beginObject();
+			std::string_view key;
+			while (parser.nextMember(key)) {
+				typename M::value_type& element = value.emplace_back();
+				element.name = key;
+				decode(parser, element);
+			}
+		}
+		else {
+			static_assert(HasSchema<M>, "no decoder for member type");
+			decode(parser, value);
+		}
+	}
+
+	template<typename T, size_t... Is>
+	void decodeField(JSONParser& parser, T& object, size_t fieldIdx, std::index_sequence<Is...>) {
+		//runtime field idx to the compile-time field, each branch is decoded with its own member type
+		bool decoded = ((fieldIdx == Is ? (decodeValue(parser, object.*(std::get<Is>(Schema<T>::fields).member)), true) : false) || ...);
+		if (!decoded) parser.skipValue();
+	}
+
+	template<typename T>
+	void decode(JSONParser& parser, T& object) {
+		constexpr size_t N = std::tuple_size_v<decltype(Schema<T>::fields)>;
+		static_assert(KEYS<T>.seed != KEYS<T>.NO_SEED, "no perfect hash seed found for schema keys");
+		[[maybe_unused]]
+		bool isObject = parser.beginObject();
+		assert(isObject);
+		std::string_view key;
+		while (parser.nextMember(key)) {
+			size_t fieldIdx = KEYS<T>.find(key);
+			if constexpr (requires { object.present; }) {
+				if (fieldIdx != N) object.present |= (uint64_t(1) << fieldIdx);
+			}
+			decodeField(parser, object, fieldIdx, std::make_index_sequence<N>{});
+		}
+	}
+}
+
+//true if key was present in the decoded object, key is checked against the schema at compile time
+#define S72_HAS(object, key) (((object).present & S72::fieldBit<std::decay_t<decltype(object)>>(key)) != 0)
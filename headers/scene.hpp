@@ -5,8 +5,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <string>
+#include <memory>
 
-#include "jsonParsing.hpp"
+#include "s72Schema.hpp"
 #include "parameters.hpp"
 #include "entityComponent.hpp"
 #include "material.hpp"
@@ -14,6 +15,7 @@
 #include "mesh.hpp"
 #include "animation.hpp"
 #include "camera.hpp"
+#include "utils.hpp"
 
 //TODO consider saving as simple mat4 ?
 struct Transform {
@@ -58,6 +60,9 @@ struct Scene {
 		//for some reason using default causes error with clang, but this works...
 		SceneNode() noexcept{}; //NOTE creates new entity
 		SceneNode(Transform _transform, entitySize_t _sibling, entitySize_t _child) : transform(_transform), sibling(_sibling), child(_child) {};
+		//NOTE does not create a new entity, used when restoring from the scene cache
+		SceneNode(Transform _transform, Entity _entity, entitySize_t _sibling, entitySize_t _child, entitySize_t _parent) : 
+			transform(_transform), entity(_entity), sibling(_sibling), child(_child), parent(_parent) {};
 
 		const bool hasSibling() const {
 			return (sibling != std::numeric_limits<entitySize_t>().max());
@@ -78,6 +83,8 @@ struct Scene {
 
 	EnitityComponents<SceneNode> graph{};
 	EnitityComponents<Mesh> meshes{};
+	//meshlets of every mesh with CLUSTER, each mesh's are Mesh::numMeshlets from Mesh::meshletOffset
+	std::vector<Meshlet> meshlets{};
 	EnitityComponents<Material> materials{};
 	entitySize_t renderCameraID = std::numeric_limits<entitySize_t>().max();
 	entitySize_t cullingCameraID = std::numeric_limits<entitySize_t>().max();
@@ -96,16 +103,44 @@ struct Scene {
 	Scene() = default;
 	Scene(std::string filename, const ModeConstantParameters& parameters = ModeConstantParameters());
 	void printScene(const ModeConstantParameters& parameters);
+	//one indexed draw, the whole mesh, one of its LODs or with CLUSTER a run of its visible meshlets
 	struct DrawParameters {
 		glm::mat4 modelMat = glm::mat4();
 		std::vector<Mesh>::const_iterator mesh;
+		uint32_t indexOffset = 0; //offset into index buffer
+		uint32_t numIndices = 0;
 	};
 
 	void updateDrivers(float totalElapsed, const ModeConstantParameters& parameters = ModeConstantParameters());
 	glm::mat4 getParentToLocalFullSingular(entitySize_t entityID);
 	bool frustumCull(const std::vector<glm::vec4>& frustumPlanes, const Bounds& meshBounds, const glm::mat4& modelMat);
+	//mesh's bounding sphere against frustumPlanes (normalized), and its oriented bounds if the sphere straddles one
+	bool frustumCull(const std::vector<glm::vec4>& frustumPlanes, const Mesh& mesh, const glm::mat4& modelMat);
+	//with CLUSTER, appends draws for the runs of mesh's meshlets that are in the frustum (with FRUSTUM_CULLING) and
+	//have a triangle facing eye, see Meshlet::backfacing
+	void drawMeshlets(std::vector<DrawParameters>& drawParams, const std::vector<glm::vec4>& frustumPlanes, glm::vec3 eye, const glm::mat4& modelMat,
+		std::vector<Mesh>::const_iterator mesh, const ModeConstantParameters& parameters);
+	//with LOD_LEVELS an instance is drawn with LOD n once its bounding sphere spans less than LOD_SCREEN_SIZE / 2^(n - 1)
+	//of half the render camera's view height, which keeps LOD n's error (see Mesh::LOD_ERROR) to a few pixels at 1080p.
+	//an instance only changes LOD once it is LOD_HYSTERESIS past the switching size, so one sitting on it doesn't flicker
+	static inline constexpr float LOD_SCREEN_SIZE = 0.25f;
+	static inline constexpr float LOD_HYSTERESIS = 0.15f;
+	//LOD to draw an instance of mesh with that spans screenSize of half the view height, and was drawn with lastLod
+	static uint32_t selectLod(const Mesh& mesh, float screenSize, uint32_t lastLod);
 	void drawScene(std::vector<DrawParameters>& drawParams, glm::mat4& viewTransform, glm::mat4& projTransform, const ModeConstantParameters& parameters = ModeConstantParameters());
 
+	//with STREAM_MESHES meshes are read on background threads after the constructor returns and aren't drawn until resident
+	//call once per frame, moves meshes that finished loading into the global buffers and marks what was appended
+	//for upload (see dirtyVertexRanges), returns false once every mesh is resident
+	bool updateStreaming(const ModeConstantParameters& parameters = ModeConstantParameters());
+
+	//with HOT_RELOAD the scene and mesh files are watched, call once per frame. when one is written the scene file is
+	//parsed again and diffed against the loaded scene by object name, changed transforms, cameras and drivers are
+	//patched in place and meshes whose data changed are rewritten into their existing vertex / index ranges and marked
+	//for upload. added, removed or re-referenced objects and meshes that outgrow their ranges are only reported
+	//returns true if anything was patched
+	bool updateHotReload(const ModeConstantParameters& parameters = ModeConstantParameters());
+
 	entitySize_t addSceneNode(entitySize_t parent = std::numeric_limits<entitySize_t>().max(), SceneNode node = SceneNode());
 	entitySize_t addCamera(entitySize_t parent = std::numeric_limits<entitySize_t>().max(), const Camera& camera = Camera());
 	entitySize_t addOrbitCamera(entitySize_t parent = std::numeric_limits<entitySize_t>().max(), const OrbitControl& orbit = OrbitControl(), const Camera& camera = Camera());
@@ -123,40 +158,101 @@ private:
 		LIGHT,
 		NONE
 	};
-	struct tmpNodeData {
-		//TODO reconfigure JSON parser to pass references, may save a lot in excessive copy calls?
-		Object object;
-		uint32_t references = 0; //how many nodes actually reference this node ? 
+	//the scene file is streamed one top-level object at a time, so only what is needed to build the graph
+	//from the roots is kept around. every object name and every name reference is interned once while merging,
+	//all loader maps below key on atoms after that, names themselves are views into the parser's file buffer
+	AtomTable tempAtoms{};
+	//atom of --camera, NO_ATOM if no object is named that
+	atom_t tempStartCamera = NO_ATOM;
+	//references of a node resolved to atoms, NO_ATOM where the node has none
+	struct tmpNode {
+		S72Node data;
+		atom_t mesh = NO_ATOM;
+		atom_t camera = NO_ATOM;
+		atom_t environment = NO_ATOM;
+		atom_t light = NO_ATOM;
+		std::vector<atom_t> children{};
 	};
-	struct tmpNodeIdx {
-		objType type;
-		std::string name;
-
-		bool operator==(const tmpNodeIdx& other) const {
-			return type == other.type && name == other.name;
-		}
+	struct tmpMesh {
+		S72Mesh data;
+		atom_t material = NO_ATOM;
 	};
-	struct tmpNodeIdxHasher {
-		std::size_t operator()(const tmpNodeIdx& key) const {
-			std::size_t h2 = std::hash<uint8_t>{}(static_cast<uint8_t>(key.type));
-			std::size_t h1 = std::hash<std::string>{}(key.name);
-			return h1 ^ (h2 << 1);
-		}
-	};
-
-	std::unordered_map<tmpNodeIdx, tmpNodeData, tmpNodeIdxHasher> tempGraph{};
-	//names may be aliased so we need a map per type of component
+	std::unordered_map<atom_t, tmpNode> tempNodes{};
+	//MESH, MATERIAL, CAMERA, LIGHT and ENVIRONMENT objects are decoded into their typed structs and kept until first referenced
+	std::unordered_map<atom_t, tmpMesh> tempMeshes{};
+	std::unordered_map<atom_t, S72Material> tempMaterials{};
+	std::unordered_map<atom_t, S72Camera> tempCameras{};
+	std::unordered_map<atom_t, S72Environment> tempEnvironments{};
+	std::unordered_map<atom_t, S72Light> tempLights{};
+	//names may be aliased so we need a map per type of component, keyed on tmpComponentKey(type, atom)
 	//for SceneNode, val is entityID,
 	//for all else (componenets) idxs into _data components of EntityComponent arrays
-	std::unordered_map<tmpNodeIdx, uint32_t, tmpNodeIdxHasher> tempComponents{}; 
-	std::vector<std::pair<std::string, Object>> tempDrivers{};
+	static uint64_t tmpComponentKey(objType type, atom_t atom) { return (static_cast<uint64_t>(type) << 32) | atom; };
+	std::unordered_map<uint64_t, uint32_t> tempComponents{}; 
+	//drivers are converted as soon as they are streamed, paired with the atom of the node they animate
+	std::vector<std::pair<atom_t, Driver>> tempDrivers{};
 	std::vector<Vertex> tempDebugVertices{};
+	//meshes referenced by the graph, in the order they were added to meshes, read in parallel once the graph is built
+	struct tmpMeshLoad {
+		const S72Mesh* s72Mesh;
+		std::string sourceFile;
+	};
+	std::vector<tmpMeshLoad> tempMeshLoads{};
+	//resolved paths of every file the scene was built from, recorded in the scene cache to detect stale caches
+	std::vector<std::string> tempSourceFiles{};
+	//sizes of the global vertex / index buffers before this scene appended to them
+	size_t tempVerticesBase = 0;
+	size_t tempIndicesBase = 0;
+	//vertices of each mesh in meshes' _data, only recorded with HOT_RELOAD
+	std::vector<BufferRange> tempMeshVertexRanges{};
+
+	//objects decoded from one range of the scene array, ranges are decoded in parallel then merged in file order
+	struct tmpObjectChunk {
+		std::vector<S72Node> nodes{};
+		std::vector<S72Mesh> meshes{};
+		std::vector<S72Material> materials{};
+		std::vector<S72Camera> cameras{};
+		std::vector<S72Environment> environments{};
+		std::vector<S72Light> lights{};
+		std::vector<std::pair<std::string_view, Driver>> drivers{};
+		std::vector<S72Scene> scenes{};
+	};
+	//decodes the whole scene array into the temp maps, parser must outlive them
+	void parseObjects(JSONParser& parser, std::vector<std::string_view>& rootNames, bool& hasRoots, const ModeConstantParameters& parameters);
+	void readObjects(JSONParser& parser, tmpObjectChunk& chunk, const ModeConstantParameters& parameters);
+	void mergeObjects(tmpObjectChunk& chunk);
+	atom_t internReference(std::string_view name) { return name.empty() ? NO_ATOM : tempAtoms.intern(name); };
+
+	SceneNode initNode(atom_t nodeAtom, const ModeConstantParameters& parameters, const entitySize_t parent);
+	Mesh initMesh(const S72Mesh& s72Mesh);
+	Material initMaterial(const S72Material& s72Material, const ModeConstantParameters& parameters);
+	Camera initCamera(const S72Camera& s72Camera, const ModeConstantParameters& parameters);
+	Environment initEnvironment(const S72Environment& s72Environment, const ModeConstantParameters& parameters);
+	Light initLight(const S72Light& s72Light, const ModeConstantParameters& parameters);
+	Driver initDriver(S72Driver&& s72Driver, const ModeConstantParameters& parameters);
+	void loadMeshes(const ModeConstantParameters& parameters);
+	static std::vector<uint32_t> geometrySources(const std::vector<tmpMeshLoad>& loads);
+	//points mesh at a copy of meshMeshlets on the end of meshlets
+	void appendMeshlets(Mesh& mesh, const std::vector<Meshlet>& meshMeshlets);
+	//LOD each instance was last drawn with, by a hash of its path of node entities from the root since a node can be
+	//the child of more than one node, see selectLod and drawScene
+	std::unordered_map<uint64_t, uint8_t> instanceLods{};
+	void addDebugBounds(Mesh& mesh, std::string_view name, const ModeConstantParameters& parameters);
+
+	//background mesh loading, see updateStreaming. shared so Scene stays copyable, the last owner joins the worker
+	struct MeshStream;
+	std::shared_ptr<MeshStream> meshStream{};
+	void startMeshStream(JSONParser&& sceneParser, const std::string& scenePath, const ModeConstantParameters& parameters);
+
+	//names and load state of everything hot reload can patch, see updateHotReload. shared for the same reason as meshStream
+	struct HotReload;
+	std::shared_ptr<HotReload> hotReload{};
+	//records the loaded scene from the temp maps, call before they are cleared
+	void startHotReload(const std::string& scenePath, const std::vector<std::string_view>& rootNames, const ModeConstantParameters& parameters);
+	void clearTempObjects();
 
-	SceneNode initNode(const Object& JSONObj, const ModeConstantParameters& parameters, const entitySize_t parent);
-	Mesh initMesh(const Object& JSONObj, const ModeConstantParameters& parameters);
-	Material initMaterial(const Object& JSONobj, const ModeConstantParameters& parameters);
-	Camera initCamera(const Object& JSONObj, const ModeConstantParameters& parameters);
-	Environment initEnvironment(const Object& JSONObj, const ModeConstantParameters& parameters);
-	Light initLight(const Object& JSONObj, const ModeConstantParameters& parameters);
-	Driver initDriver(const Object& JSONObj, entitySize_t entityID, const ModeConstantParameters& parameters);
+	//binary scene cache, see sceneCache.hpp
+	//loadCache returns false, leaving the scene untouched, if there is no cache or it is stale
+	bool loadCache(const std::string& scenePath, const ModeConstantParameters& parameters);
+	void saveCache(const std::string& scenePath, const ModeConstantParameters& parameters);
 };
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// ================================================================================================
+// S72B : binary cache of a fully loaded Scene, see Scene::loadCache / Scene::saveCache
+// ================================================================================================
+
+//written next to the scene file after every load from source, and mapped on the next launch instead of parsing
+//the scene and reading every mesh file, as long as none of the files it was built from have changed
+//every array is a flat POD section addressed by byte offset from the start of the file, so there are no pointers
+//in the file and it can be mapped at any address. entity ids are stored relative to the first id of the scene and
+//rebased onto freshly reserved ids when loaded
+namespace S72B {
+	inline constexpr char MAGIC[4] = { 'S', '7', '2', 'B' };
+	//bump whenever the layout of anything written to the file changes
+	inline constexpr uint32_t VERSION = 7;
+	inline constexpr uint64_t SECTION_ALIGNMENT = 16;
+
+	struct Section {
+		uint64_t offset = 0; //bytes from the start of the file
+		uint64_t count = 0; //number of elements, not bytes
+	};
+
+	//string stored in the STRINGS section
+	struct StringRef {
+		uint64_t offset = 0;
+		uint64_t size = 0;
+	};
+
+	//file the cached scene was built from. size and write time are checked first, the contents are only
+	//hashed again when one of them differs, so touching a file without changing it doesn't invalidate the cache
+	struct Source {
+		StringRef path{};
+		uint64_t size = 0;
+		int64_t writeTime = 0;
+		uint64_t hash = 0;
+	};
+
+	//one (entity id, idx into data) pair of an EnitityComponents
+	struct IdxEntry {
+		uint32_t id = 0;
+		uint32_t idx = 0;
+	};
+
+	//Driver without its vectors, times and values are ranges of the DRIVER_FLOATS section
+	struct DriverRecord {
+		uint32_t entityID = 0;
+		uint32_t flags = 0; //see driverFlags in sceneCache.cpp
+		uint64_t timesOffset = 0;
+		uint64_t timesCount = 0;
+		uint64_t valuesOffset = 0;
+		uint64_t valuesCount = 0;
+	};
+
+	enum SectionType : uint32_t {
+		STRINGS,
+		SOURCES,
+		NODES,
+		NODE_IDXS,
+		MESHES,
+		MESH_IDXS,
+		MATERIALS,
+		MATERIAL_IDXS,
+		CAMERAS,
+		CAMERA_IDXS,
+		ORBIT_CONTROLS,
+		ORBIT_CONTROL_IDXS,
+		LIGHTS,
+		LIGHT_IDXS,
+		ENVIRONMENTS,
+		ENVIRONMENT_IDXS,
+		DRIVERS,
+		DRIVER_FLOATS,
+		DRIVER_IDXS,
+		VERTICES,
+		INDICES,
+		MESHLETS,
+		SECTION_COUNT
+	};
+
+	struct Header {
+		char magic[4] = { MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3] };
+		uint32_t version = VERSION;
+		//build and parameter dependent state, the cache is rebuilt if any of these differ
+		uint32_t vertexSize = 0;
+		uint32_t indexSize = 0;
+		uint32_t nodeSize = 0;
+		uint32_t meshSize = 0;
+		uint32_t debugView = 0;
+		uint32_t meshOptions = 0; //see meshOptions in sceneCache.cpp
+		uint64_t startCameraHash = 0;
+		//meshes index into the global vertex / index buffers, so they must hold exactly this much before loading
+		uint64_t verticesBase = 0;
+		uint64_t indicesBase = 0;
+
+		StringRef fileVersion{};
+		uint32_t firstEntityID = 0;
+		uint32_t entityCount = 0;
+		uint32_t rootID = 0;
+		uint32_t renderCameraID = 0;
+		uint32_t cullingCameraID = 0;
+		uint32_t sharedDebugIndexOffset = 0;
+		uint32_t sharedDebugVertexOffset = 0;
+		uint32_t _pad2 = 0;
+		Section sections[SECTION_COUNT]{};
+	};
+
+	//{scene}.s72 -> {scene}.s72b, any other name just gets .s72b appended
+	std::string cachePath(const std::string& scenePath);
+
+	//XXH64, see hashXXH64
+	uint64_t hashBytes(const char* data, size_t size);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "vertexIndex.hpp"
+
+// quadric error simplification of indexed triangle lists, for the LOD chain (--lod-levels)
+// edges are collapsed onto one of their two vertices (Garland and Heckbert, "Surface Simplification Using Quadric
+// Error Metrics", https://www.cs.cmu.edu/~garland/Papers/quadrics.pdf, without the optimal placement), so every LOD
+// indexes the mesh's own vertices and only needs an extra index range. collapses are made in passes, cheapest first,
+// each pass only collapsing edges whose neighbourhoods don't overlap, and never folding a triangle over.
+// vertices on open borders or attribute seams (several vertices at one position) never move, so LODs keep their
+// silhouette edges and don't tear along uv / normal seams
+
+//index counts of the LODs of one or more meshes
+struct SimplifyStats {
+	uint64_t baseIndices = 0; //LOD 0, the mesh as loaded
+	uint64_t lodIndices = 0; //every other LOD
+	uint64_t lods = 0; //not counting LOD 0
+
+	SimplifyStats& operator+=(const SimplifyStats& other) {
+		baseIndices += other.baseIndices;
+		lodIndices += other.lodIndices;
+		lods += other.lods;
+		return *this;
+	}
+};
+
+//indices is a triangle list into the numVertices vertices. writes at most numIndices indices of a simplified list into
+//out, stopping once it has at most targetIndices or the next collapse would move the surface further than maxError
+//(in the mesh's units). returns the number of indices written, and the furthest any collapse moved the surface in
+//errorOut if given
+uint32_t simplifyMesh(const Vertex* vertices, uint32_t numVertices, const Index* indices, uint32_t numIndices, uint32_t targetIndices, float maxError,
+	Index* out, float* errorOut = nullptr);
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "vertexIndex.hpp"
+
+// triangle list to triangle strip conversion, strips are joined by PRIMITIVE_RESTART_IDX so a whole mesh is still
+// one indexed draw, with the strip pipeline (see App::createGraphicsPipeline)
+// strips are grown greedily across shared edges, starting from triangles in index buffer order, so strips follow
+// whatever locality the triangle order already has (see optimizeVertexCache). each strip is started from the
+// rotation of its first triangle that grows the longest strip, and only takes triangles whose winding it keeps
+
+//index counts before and after stripify of one or more meshes
+struct StripifyStats {
+	uint64_t listIndices = 0;
+	uint64_t stripIndices = 0; //including restart indices
+	uint64_t strips = 0;
+
+	StripifyStats& operator+=(const StripifyStats& other) {
+		listIndices += other.listIndices;
+		stripIndices += other.stripIndices;
+		strips += other.strips;
+		return *this;
+	}
+};
+
+//most indices stripify can write for a list of numIndices, every triangle its own strip
+inline uint32_t maxStripIndices(uint32_t numIndices) { return numIndices / 3 * 4; }
+
+//indices is a triangle list, none of them PRIMITIVE_RESTART_IDX, strips is overwritten with the joined strips
+StripifyStats stripify(const Index* indices, uint32_t numIndices, std::vector<Index>& strips);
@@ -1,8 +1,109 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
 
 std::vector<char> readFile(const std::string& filename);
 
 std::vector<char> readShader(const std::string& filename);
 
+//number of worker threads to use for a requested count, 0 means one per hardware thread
+size_t resolveThreadCount(int requested);
+
+//calls func(taskIdx) for every taskIdx in [0, taskCount) on up to numThreads threads, tasks are handed out
+//dynamically so uneven tasks still balance. runs inline when numThreads or taskCount is 1
+//the first exception thrown by a task is rethrown once every thread has joined
+void parallelFor(size_t taskCount, size_t numThreads, const std::function<void(size_t)>& func);
+
+//64 bit xxHash (XXH64), reads 32 bytes per step so bulk data like mesh geometry hashes at memory speed
+uint64_t hashXXH64(const void* data, size_t size, uint64_t seed = 0);
+
+
+//read-only view of a whole file, memory mapped where the platform supports it so nothing is copied up front
+//and pages are faulted in lazily, otherwise falls back to a single read into an owned buffer
+class MappedFile {
+	const char* _data = nullptr;
+	size_t _size = 0;
+	std::vector<char> _buffer{}; //only used by the read fallback
+	bool _mapped = false;
+#ifdef _WIN32
+	void* _fileHandle = nullptr;
+	void* _mappingHandle = nullptr;
+#endif
+
+	bool readFallback(const std::string& filename);
+
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	//returns false if the file does not exist or can't be opened
+	bool open(const std::string& filename);
+	void close();
+
+	//stays valid across moves of this object
+	const char* data() const { return _data; };
+	size_t size() const { return _size; };
+	bool isMapped() const { return _mapped; };
+};
+
+
+//32 bit id of an interned name, atoms are handed out densely in the order names are first interned
+typedef uint32_t atom_t;
+inline constexpr atom_t NO_ATOM = std::numeric_limits<atom_t>::max();
+
+//string interning table, each distinct name is hashed once when interned and compared as an integer after that
+//only views are stored, so interned names must outlive the table (scene names are views into the parser's buffer)
+class AtomTable {
+	std::unordered_map<std::string_view, atom_t> _atoms{};
+	std::vector<std::string_view> _names{}; //indexed by atom
+
+public:
+	//returns the existing atom of name, or a new one
+	atom_t intern(std::string_view name);
+	//NO_ATOM if name was never interned, doesn't add it
+	atom_t find(std::string_view name) const;
+	std::string_view name(atom_t atom) const { return _names[atom]; };
+	size_t size() const { return _names.size(); };
+	void reserve(size_t count);
+	void clear();
+};
+
+//reports which of a set of files were written. uses inotify on linux, where it costs nothing until a file changes,
+//elsewhere (or if inotify is unavailable) polls the size and write time of every file a few times a second
+class FileWatcher {
+	std::vector<std::string> _paths{};
+	//polling fallback, size and write time of each path when last polled. a change is only reported once the stamp
+	//has held for a whole poll, so files aren't picked up halfway through being written
+	std::vector<std::pair<uint64_t, int64_t>> _stamps{};
+	std::vector<bool> _pending{};
+	int64_t _lastPoll = 0;
+#ifdef __linux__
+	int _inotify = -1;
+	//watch descriptor of each path's directory, files are usually replaced by a rename so the files aren't watched directly
+	std::vector<int> _directoryWatches{};
+	std::vector<std::string> _fileNames{};
+#endif
+
+	void stampAll();
+
+public:
+	FileWatcher() = default;
+	~FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	//replaces the set of watched files, changes made before this call aren't reported
+	void watch(const std::vector<std::string>& paths);
+	//appends every watched path written since the last call, returns false if there were none
+	bool poll(std::vector<std::string>& changed);
+};
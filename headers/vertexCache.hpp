@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "vertexIndex.hpp"
+
+// post-transform vertex cache optimization of indexed triangle lists
+// triangles are reordered with Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality
+// and Reduced Overdraw", https://gfx.cs.princeton.edu/pubs/Sander_2007_%3ETR/tipsy.pdf), a linear time greedy
+// fan walk that keeps recently used vertices in a simulated FIFO cache, then vertices are renumbered in the order
+// the new triangles first use them so vertex fetches walk the buffer forwards
+
+//size of the FIFO cache triangles are ordered for and measured against, about what current hardware keeps
+inline constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+//vertex shader invocations of an index buffer under a simulated FIFO cache
+struct VertexCacheStats {
+	uint64_t triangles = 0;
+	uint64_t vertices = 0;
+	uint64_t transformed = 0; //cache misses
+
+	//average cache miss ratio, transformed vertices per triangle, 0.5 at best for large regular meshes and 3 at worst
+	double acmr() const { return triangles ? static_cast<double>(transformed) / triangles : 0.0; };
+	//average transform to vertex ratio, transformed vertices per vertex, 1 at best
+	double atvr() const { return vertices ? static_cast<double>(transformed) / vertices : 0.0; };
+
+	VertexCacheStats& operator+=(const VertexCacheStats& other) {
+		triangles += other.triangles;
+		vertices += other.vertices;
+		transformed += other.transformed;
+		return *this;
+	}
+};
+
+//before and after optimizeVertexCache + optimizeVertexFetch of one or more meshes
+struct VertexCacheReport {
+	VertexCacheStats before{};
+	VertexCacheStats after{};
+
+	VertexCacheReport& operator+=(const VertexCacheReport& other) {
+		before += other.before;
+		after += other.after;
+		return *this;
+	}
+};
+
+//triangles using each vertex of a triangle list, packed so the triangles of vertex v are triangles[offsets[v], offsets[v + 1])
+//indices must all be < numVertices
+struct VertexTriangles {
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> triangles;
+
+	VertexTriangles(const Index* indices, uint32_t numIndices, uint32_t numVertices) : offsets(numVertices + 1, 0), triangles(numIndices) {
+		for (uint32_t i = 0; i < numIndices; i++) offsets[indices[i] + 1]++;
+		for (uint32_t v = 0; v < numVertices; v++) offsets[v + 1] += offsets[v];
+		std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+		for (uint32_t i = 0; i < numIndices; i++) triangles[next[indices[i]]++] = i / 3;
+	}
+	uint32_t count(uint32_t vertex) const { return offsets[vertex + 1] - offsets[vertex]; };
+};
+
+//indices is a triangle list into numVertices vertices
+VertexCacheStats analyzeVertexCache(const Index* indices, uint32_t numIndices, uint32_t numVertices, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+//reorders the triangles of indices in place, each triangle keeps its winding
+void optimizeVertexCache(Index* indices, uint32_t numIndices, uint32_t numVertices, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+//renumbers vertices in place in the order indices first use them and rewrites indices to match, vertices no
+//triangle uses are dropped. returns the number of vertices left
+uint32_t optimizeVertexFetch(Vertex* vertices, uint32_t numVertices, Index* indices, uint32_t numIndices);
@@ -4,6 +4,7 @@
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <string>
 
 #if defined(SIMPLE_VERTEX) && SIMPLE_VERTEX
 //type definitions
@@ -60,10 +61,73 @@ extern std::vector<Vertex> vertices;
 extern std::vector<Index> indices;
 extern Index PRIMITIVE_RESTART_IDX;
 
+//number of vertices / indices the device buffers are created with if larger than vertices.size() / indices.size(),
+//set when meshes are streamed in after the buffers are created, see Scene::updateStreaming, or to leave room for
+//meshes that grow when hot reloaded, see Scene::updateHotReload
+extern uint32_t reservedVertices;
+extern uint32_t reservedIndices;
+
+//[first, first + count) elements of vertices / indices written since the device buffers were last updated,
+//see App::uploadDirtyVertexIndexRanges
+struct BufferRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+extern std::vector<BufferRange> dirtyVertexRanges;
+extern std::vector<BufferRange> dirtyIndexRanges;
+//set if any dirty range overwrites data frames may have drawn from (hot reload patching a mesh in place) rather than
+//room never drawn from (streaming), the upload then waits for the frames in flight first
+extern bool dirtyRangesInUse;
+
+//set while something may still write to vertices / indices after the device buffers are created (streaming, hot reload)
+//otherwise the device buffers are the only copy needed once created, see releaseVertexIndexData
+extern bool retainVertexIndexData;
+//frees vertices / indices, keeping the device buffer sizes through reservedVertices / reservedIndices
+void releaseVertexIndexData();
+
+//how vertices are laid out in the device vertex buffer. vertices always holds full Vertex, which loading, welding,
+//culling and the scene cache work on, and is encoded into the active layout as it is staged for upload
+struct VertexLayout {
+    std::string name;
+    uint32_t stride = sizeof(Vertex);
+    std::vector<VkVertexInputAttributeDescription> attributes{};
+    //writes count vertices from src to dst, stride bytes each
+    void (*encode)(const Vertex* src, uint32_t count, void* dst) = nullptr;
+    //bytes at the start of each vertex holding its position (location 0) and nothing else, 0 if the layout
+    //can't be split, see splitVertexPositions
+    uint32_t positionSize = 0;
+};
+
+//layouts selectable with --vertex-layout, "full" (Vertex as is) is always first
+//  compact : 24 bytes, positions as int16 with a shared per vertex exponent, octahedral snorm16 normal and tangent
+//            (the tangent's handedness in the sign of its second component), half float texCoord, color as is
+const std::vector<VertexLayout>& vertexLayouts();
+//adds layout to vertexLayouts, returns its id
+uint32_t registerVertexLayout(VertexLayout layout);
+//id of the layout named name, throws if there is none
+uint32_t findVertexLayout(const std::string& name);
+//layout the device buffers and pipelines use, set before either is created
+extern uint32_t activeVertexLayout;
+inline const VertexLayout& getVertexLayout() { return vertexLayouts()[activeVertexLayout]; }
+
+//if set the device vertex region holds two streams instead of interleaved vertices, the positions of every vertex packed
+//tightly (binding 0, the first positionSize bytes of the layout) and then the rest of the layout (binding 1), so
+//depth only pipelines read nothing but positions, see App::createGraphicsPipeline. set with activeVertexLayout
+extern bool splitVertexPositions;
+//streams the device vertex region is split into, 1 or 2
+uint32_t vertexStreamCount();
+//bytes per vertex of stream, the layout's stride if there is only one
+uint32_t vertexStreamStride(uint32_t stream);
+//byte offset of stream in a device vertex region sized for numVertices
+VkDeviceSize vertexStreamOffset(uint32_t stream, uint32_t numVertices);
+//writes stream's part of count vertices from src to dst in the active layout, vertexStreamStride(stream) bytes each
+void encodeVertexStream(const Vertex* src, uint32_t count, uint32_t stream, void* dst);
+
 //functions likely to differ between programs
-VkVertexInputBindingDescription getVertexBindingDescription();
+//positionsOnly leaves out everything but the position, for pipelines that only write depth
+std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions(bool positionsOnly = false);
 
-std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions();
+std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions(bool positionsOnly = false);
 
 void vertexBufferSize(uint32_t* numElements, uint32_t* elementSize);
 
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+#include "vertexIndex.hpp"
+
+// vertex welding, turns a triangle soup into indexed geometry by merging bitwise identical vertices
+// uses an open-addressing table sized up front, so no allocation per unique vertex, keyed on a hash of every byte
+// of the vertex. the hash uses SSE2 on any x86-64 build and a scalar fallback elsewhere that gives the same values,
+// define VERTEX_WELD_FORCE_SCALAR to disable the SIMD path
+
+//hash of all sizeof(Vertex) bytes of vertex
+uint64_t hashVertex(const Vertex& vertex);
+
+//below this many vertices welding always runs on the calling thread
+inline constexpr uint32_t WELD_PARALLEL_MIN_VERTICES = 1 << 16;
+
+//most unique vertices Index can number, its max is left for PRIMITIVE_RESTART_IDX
+inline constexpr uint32_t WELD_MAX_UNIQUE = std::numeric_limits<Index>::max();
+
+//welds the count vertices in place, the first copy of each vertex moves down to the end of the unique ones seen so
+//far, and writes count indices into indicesOut. returns the number of unique vertices, which come out in the order
+//they first appear whatever numThreads is
+//if there are more than WELD_MAX_UNIQUE unique vertices it stops at the first one that doesn't fit and returns
+//WELD_MAX_UNIQUE + 1, leaving vertices and indicesOut partly written but never writing a truncated index
+//with numThreads > 1 and at least WELD_PARALLEL_MIN_VERTICES vertices, vertices are split by hash into one
+//partition per thread and each partition is welded on its own, since identical vertices always share a partition
+uint32_t weldVertices(Vertex* vertices, uint32_t count, Index* indicesOut, size_t numThreads = 1);
@@ -289,6 +289,8 @@ private:
     void createSynchObjects();
 public:
     void initProgram(Mode& mode);
+    //copies vertices / indices written since the last call into the device buffers, defined in vertexIndex.cpp
+    void uploadDirtyVertexIndexRanges();
 
 // FUNCTIONS USED FOR DRAWING, SOME EXPOSED TO Mode.hpp
     void updateUniformBuffer(uint32_t uniformIndex, const void* uniformData, uint32_t uniformSize) const;
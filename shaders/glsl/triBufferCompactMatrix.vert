@@ -0,0 +1,36 @@
+#version 450
+
+//compact vertex layout, see vertexLayouts in vertexIndex.hpp
+layout(location = 0) in ivec4 inPosition;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inTangent;
+layout(location = 3) in vec2 inTexCoord;
+layout(location = 4) in vec4 inColor;
+
+layout(location = 0) out vec4 fragVertexColor;
+layout(location = 1) out vec3 fragNormal;
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+layout(push_constant, std430) uniform pushConstant {
+    mat4 model;
+} pc;
+
+vec3 octahedralDecode(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float fold = max(-v.z, 0.0);
+	v.x += v.x >= 0.0 ? -fold : fold;
+	v.y += v.y >= 0.0 ? -fold : fold;
+	return normalize(v);
+}
+
+void main() {
+	vec3 position = vec3(inPosition.xyz) * exp2(float(inPosition.w));
+	gl_Position = ubo.proj * ubo.view * pc.model * vec4(position, 1.0);
+	fragVertexColor = inColor;
+	//TODO if theres no non-uniform scaling, don't need inverse transpose, just model matrix
+	fragNormal = (inverse(transpose(pc.model)) * vec4(octahedralDecode(inNormal), 0.0)).xyz;
+}
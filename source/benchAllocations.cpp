@@ -0,0 +1,30 @@
+#include "benchAllocations.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// kept in its own translation unit so the replacements are never inlined into code that allocates, which is what lets
+// the compiler pair them up as mismatched new / free
+
+namespace {
+	std::atomic<size_t> allocationCount = 0;
+	std::atomic<size_t> allocationBytes = 0;
+
+	void* countedAlloc(size_t size) {
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocationBytes.fetch_add(size, std::memory_order_relaxed);
+		if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+		throw std::bad_alloc();
+	}
+}
+
+AllocationCounts allocationCounts() {
+	return { allocationCount.load(std::memory_order_relaxed), allocationBytes.load(std::memory_order_relaxed) };
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
@@ -0,0 +1,336 @@
+// throughput benchmark for JSONParser, built as real_bench_json
+// generates synthetic documents in memory, parses each one with every parser mode and reports
+// MB/s (best of --iterations), heap allocations per parse and the process peak RSS after each mode
+//
+// usage : real_bench_json [--size-mb {n}] [--iterations {n}] [--depth {n}] [--threads {n}]
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include <cstdio>
+#include <random>
+
+#include "jsonParsing.hpp"
+#include "jsonStructural.hpp"
+#include "s72Schema.hpp"
+#include "utils.hpp"
+#include "benchAllocations.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+	//in MB, 0 if the platform can't report it
+	double peakRSS() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0.0;
+		return static_cast<double>(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+		rusage usage{};
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+#ifdef __APPLE__
+		return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0); //bytes
+#else
+		return static_cast<double>(usage.ru_maxrss) / 1024.0; //KB
+#endif
+#endif
+	}
+
+	struct BenchOptions {
+		size_t sizeMB = 16;
+		size_t iterations = 5;
+		size_t depth = 256;
+		int threads = 0;
+	};
+
+	// ================================================================================================
+	// DOCUMENT GENERATORS
+	// ================================================================================================
+
+	void appendFloat(std::string& out, std::mt19937& rng) {
+		//the parser wants a signed exponent, so stick to fixed notation
+		std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+		char buffer[32];
+		int length = std::snprintf(buffer, sizeof(buffer), "%.6f", dist(rng));
+		out.append(buffer, length);
+	}
+
+	//arrays and objects nested depth levels deep, repeated until the target size
+	std::string makeDeep(size_t targetBytes, size_t depth) {
+		std::string out = "[";
+		for (size_t chunk = 0; out.size() < targetBytes; chunk++) {
+			if (chunk > 0) out += ',';
+			for (size_t d = 0; d < depth; d++) out += (d % 2 == 0) ? "{\"level\":" : "[";
+			out += "\"leaf\"";
+			for (size_t d = depth; d-- > 0;) out += (d % 2 == 0) ? "}" : "]";
+		}
+		out += "]";
+		return out;
+	}
+
+	//one object with many short members of mixed types
+	std::string makeWide(size_t targetBytes) {
+		std::mt19937 rng(1);
+		std::string out = "{";
+		for (size_t member = 0; out.size() < targetBytes; member++) {
+			if (member > 0) out += ",\n  ";
+			out += "\"member" + std::to_string(member) + "\": ";
+			switch (member % 4) {
+			case 0: appendFloat(out, rng); break;
+			case 1: out += std::to_string(member); break;
+			case 2: out += "\"value " + std::to_string(member) + "\""; break;
+			default: out += (member & 4) ? "true" : "null";
+			}
+		}
+		out += "}";
+		return out;
+	}
+
+	//arrays of 4096 floats, the shape of DRIVER times/values
+	std::string makeFloats(size_t targetBytes) {
+		std::mt19937 rng(2);
+		std::string out = "[";
+		for (size_t array = 0; out.size() < targetBytes; array++) {
+			if (array > 0) out += ",\n";
+			out += "[";
+			for (size_t element = 0; element < 4096; element++) {
+				if (element > 0) out += ", ";
+				appendFloat(out, rng);
+			}
+			out += "]";
+		}
+		out += "]";
+		return out;
+	}
+
+	//.s72 scene of nodes, meshes, materials and drivers, every object type the loader decodes
+	std::string makeS72(size_t targetBytes) {
+		std::mt19937 rng(3);
+		std::string out = "[\"s72-v2\",\n{\"type\":\"SCENE\",\"name\":\"bench\",\"roots\":[\"node0\"]}";
+		for (size_t object = 0; out.size() < targetBytes; object++) {
+			const std::string idx = std::to_string(object);
+			out += ",\n";
+			switch (object % 8) {
+			case 0: case 1: case 2: case 3:
+				out += "{\"type\":\"NODE\",\"name\":\"node" + idx + "\",\"translation\":[";
+				appendFloat(out, rng); out += ","; appendFloat(out, rng); out += ","; appendFloat(out, rng);
+				out += "],\"rotation\":[0,0,0,1],\"scale\":[1,1,1],\"children\":[\"node" + std::to_string(object + 4) + "\"],\"mesh\":\"mesh" + idx + "\"}";
+				break;
+			case 4: case 5:
+				out += "{\"type\":\"MESH\",\"name\":\"mesh" + idx + "\",\"topology\":\"TRIANGLE_LIST\",\"count\":36,\"attributes\":{"
+					"\"POSITION\":{\"src\":\"mesh" + idx + ".b72\",\"offset\":0,\"stride\":52,\"format\":\"R32G32B32_SFLOAT\"},"
+					"\"NORMAL\":{\"src\":\"mesh" + idx + ".b72\",\"offset\":12,\"stride\":52,\"format\":\"R32G32B32_SFLOAT\"},"
+					"\"TANGENT\":{\"src\":\"mesh" + idx + ".b72\",\"offset\":24,\"stride\":52,\"format\":\"R32G32B32A32_SFLOAT\"},"
+					"\"TEXCOORD\":{\"src\":\"mesh" + idx + ".b72\",\"offset\":40,\"stride\":52,\"format\":\"R32G32_SFLOAT\"},"
+					"\"COLOR\":{\"src\":\"mesh" + idx + ".b72\",\"offset\":48,\"stride\":52,\"format\":\"R8G8B8A8_UNORM\"}},"
+					"\"material\":\"material" + idx + "\"}";
+				break;
+			case 6:
+				out += "{\"type\":\"MATERIAL\",\"name\":\"material" + idx + "\",\"pbr\":{\"albedo\":[0.5,0.5,0.5],\"roughness\":0.5,\"metalness\":0.0}}";
+				break;
+			default:
+				out += "{\"type\":\"DRIVER\",\"name\":\"driver" + idx + "\",\"node\":\"node" + std::to_string(object - 7) + "\",\"channel\":\"translation\",\"times\":[";
+				for (size_t key = 0; key < 64; key++) out += (key > 0 ? "," : "") + std::to_string(key) + ".5";
+				out += "],\"values\":[";
+				for (size_t key = 0; key < 64 * 3; key++) {
+					if (key > 0) out += ",";
+					appendFloat(out, rng);
+				}
+				out += "],\"interpolation\":\"LINEAR\"}";
+			}
+		}
+		out += "\n]";
+		return out;
+	}
+
+	// ================================================================================================
+	// PARSER MODES
+	// ================================================================================================
+
+	struct CountingHandler : JSONHandler {
+		size_t values = 0;
+		void startObject() override { values++; }
+		void startArray() override { values++; }
+		void number(const Number&) override { values++; }
+		void string(std::string_view) override { values++; }
+		void boolean(bool) override { values++; }
+		void null() override { values++; }
+	};
+
+	//walks a value with the cursor API the way the typed decoders do, numeric arrays go through readFloats
+	void cursorWalk(JSONParser& parser, std::vector<float>& floats, size_t& values) {
+		values++;
+		switch (parser.peekType()) {
+		case OBJECT: {
+			parser.beginObject();
+			std::string_view key;
+			while (parser.nextMember(key)) cursorWalk(parser, floats, values);
+			break;
+		}
+		case ARRAY:
+			floats.clear();
+			if (parser.readFloats(floats)) break;
+			parser.beginArray();
+			while (parser.nextElement()) cursorWalk(parser, floats, values);
+			break;
+		case NUMBER: parser.readNumber(); break;
+		case STRING: parser.readString(); break;
+		case BOOL: parser.readBool(); break;
+		default: parser.skipValue();
+		}
+	}
+
+	//decodes every top-level object of parser's range into its S72 struct, the objects are dropped right away
+	size_t decodeS72Range(JSONParser& parser) {
+		size_t objects = 0;
+		for (; parser.nextElement(); objects++) {
+			switch (S72::OBJECT_TYPES.find(parser.peekMemberString("type"))) {
+			case S72::OBJECT_TYPES.find("SCENE"): { S72Scene scene{}; S72::decode(parser, scene); break; }
+			case S72::OBJECT_TYPES.find("NODE"): { S72Node node{}; S72::decode(parser, node); break; }
+			case S72::OBJECT_TYPES.find("MESH"): { S72Mesh mesh{}; S72::decode(parser, mesh); break; }
+			case S72::OBJECT_TYPES.find("DRIVER"): { S72Driver driver{}; S72::decode(parser, driver); break; }
+			case S72::OBJECT_TYPES.find("MATERIAL"): { S72Material material{}; S72::decode(parser, material); break; }
+			default: parser.skipValue();
+			}
+		}
+		return objects;
+	}
+
+	struct ParserMode {
+		const char* name;
+		bool s72Only;
+		//returns a count of what was parsed so the work can't be optimized away
+		std::function<size_t(std::string_view document, const BenchOptions& options)> run;
+	};
+
+	const std::vector<ParserMode> PARSER_MODES = {
+		{ "stage-1", false, [](std::string_view document, const BenchOptions&) {
+			std::vector<uint32_t> structurals;
+			findStructurals(document.data(), document.size(), structurals);
+			return structurals.size();
+		} },
+		{ "dom", false, [](std::string_view document, const BenchOptions&) {
+			JSONParser parser(document);
+			Value root = parser.parse();
+			return static_cast<size_t>(root.type);
+		} },
+		{ "tape", false, [](std::string_view document, const BenchOptions&) {
+			JSONParser parser(document);
+			JSONTape tape = parser.parseTape();
+			return tape.tokens.size() + tape.floats.size();
+		} },
+		{ "events", false, [](std::string_view document, const BenchOptions&) {
+			JSONParser parser(document);
+			CountingHandler handler;
+			parser.parseEvents(handler);
+			return handler.values;
+		} },
+		{ "cursor", false, [](std::string_view document, const BenchOptions&) {
+			JSONParser parser(document);
+			std::vector<float> floats;
+			size_t values = 0;
+			cursorWalk(parser, floats, values);
+			return values;
+		} },
+		{ "skip", false, [](std::string_view document, const BenchOptions&) {
+			JSONParser parser(document);
+			parser.skipValue();
+			return size_t(1);
+		} },
+		{ "s72-typed", true, [](std::string_view document, const BenchOptions&) {
+			JSONParser parser(document);
+			parser.beginArray();
+			parser.nextElement();
+			parser.readString();
+			return decodeS72Range(parser);
+		} },
+		{ "s72-parallel", true, [](std::string_view document, const BenchOptions& options) {
+			JSONParser parser(document);
+			parser.beginArray();
+			parser.nextElement();
+			parser.readString();
+			std::vector<JSONParser> ranges = parser.splitArray(resolveThreadCount(options.threads));
+			std::vector<size_t> objects(ranges.size());
+			parallelFor(ranges.size(), ranges.size(), [&](size_t rangeIdx) { objects[rangeIdx] = decodeS72Range(ranges[rangeIdx]); });
+			size_t total = 0;
+			for (size_t count : objects) total += count;
+			return total;
+		} },
+	};
+
+	void runDocument(const char* documentName, const std::string& document, bool isS72, const BenchOptions& options) {
+		const double documentMB = static_cast<double>(document.size()) / (1024.0 * 1024.0);
+		std::cout << "\n" << documentName << " (" << std::fixed << std::setprecision(2) << documentMB << " MB)\n";
+		for (const ParserMode& mode : PARSER_MODES) {
+			if (mode.s72Only && !isS72) continue;
+
+			double bestSeconds = std::numeric_limits<double>::max();
+			size_t allocations = 0, bytes = 0, checksum = 0;
+			for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+				const AllocationCounts startAllocations = allocationCounts();
+				auto start = std::chrono::steady_clock::now();
+				checksum += mode.run(document, options);
+				auto end = std::chrono::steady_clock::now();
+				bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(end - start).count());
+				allocations = allocationCounts().count - startAllocations.count;
+				bytes = allocationCounts().bytes - startAllocations.bytes;
+			}
+
+			std::cout << "  " << std::left << std::setw(14) << mode.name << std::right
+				<< std::setw(10) << std::setprecision(1) << documentMB / bestSeconds << " MB/s"
+				<< std::setw(12) << allocations << " allocs"
+				<< std::setw(10) << std::setprecision(1) << static_cast<double>(bytes) / (1024.0 * 1024.0) << " MB alloc'd"
+				<< std::setw(10) << peakRSS() << " MB peak RSS"
+				<< "   (" << checksum << ")\n";
+		}
+	}
+
+	size_t readSizeArg(int argc, char* argv[], int& argIdx) {
+		if (argIdx + 1 >= argc) throw std::runtime_error(std::string("missing value for ") + argv[argIdx]);
+		return static_cast<size_t>(std::stoul(argv[++argIdx]));
+	}
+}
+
+int main(int argc, char* argv[]) {
+	BenchOptions options{};
+	try {
+		for (int argIdx = 1; argIdx < argc; argIdx++) {
+			const std::string arg = argv[argIdx];
+			if (arg == "--size-mb") options.sizeMB = readSizeArg(argc, argv, argIdx);
+			else if (arg == "--iterations") options.iterations = std::max<size_t>(1, readSizeArg(argc, argv, argIdx));
+			else if (arg == "--depth") options.depth = std::max<size_t>(1, readSizeArg(argc, argv, argIdx));
+			else if (arg == "--threads") options.threads = static_cast<int>(readSizeArg(argc, argv, argIdx));
+			else throw std::runtime_error("unknown argument " + arg);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << "\nusage : real_bench_json [--size-mb {n}] [--iterations {n}] [--depth {n}] [--threads {n}]" << std::endl;
+		return 1;
+	}
+
+	const size_t targetBytes = options.sizeMB * 1024 * 1024;
+	std::cout << "JSONParser benchmark, " << options.iterations << " iterations, best time reported, "
+		<< resolveThreadCount(options.threads) << " threads for s72-parallel\n";
+
+	runDocument("deep", makeDeep(targetBytes, options.depth), false, options);
+	runDocument("wide", makeWide(targetBytes), false, options);
+	runDocument("floats", makeFloats(targetBytes), false, options);
+	runDocument("s72", makeS72(targetBytes), true, options);
+	return 0;
+}
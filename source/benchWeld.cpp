@@ -0,0 +1,202 @@
+// benchmark for vertex welding (Mesh::toIndexed), built as real_bench_weld
+// generates un-indexed triangle soups in memory and welds each one with the std::unordered_map welder toIndexed
+// used before weldVertices, then with weldVertices serial and parallel. reports million input vertices per second
+// (best of --iterations), heap allocations per weld, and checks every welder gives the same vertices and indices
+//
+// usage : real_bench_weld [--vertices {n}] [--iterations {n}] [--threads {n}]
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "vertexWeld.hpp"
+#include "utils.hpp"
+#include "benchAllocations.hpp"
+
+namespace {
+	struct BenchOptions {
+		size_t vertices = 6 * 1024 * 1024;
+		size_t iterations = 5;
+		int threads = 0;
+	};
+
+	// ================================================================================================
+	// SOUP GENERATORS
+	// ================================================================================================
+
+	Vertex makeVertex(glm::vec3 position, glm::vec3 normal, glm::vec2 texCoord) {
+		Vertex vertex{};
+		vertex.position = position;
+		vertex.color = 0xFFFFFFFFU;
+#if !(defined(SIMPLE_VERTEX) && SIMPLE_VERTEX)
+		vertex.normal = normal;
+		vertex.texCoord = texCoord;
+#endif
+		return vertex;
+	}
+
+	//square grid of smoothly shaded quads, two triangles each, so most vertices appear six times
+	std::vector<Vertex> makeSmoothGrid(size_t targetVertices) {
+		const uint32_t side = static_cast<uint32_t>(std::sqrt(static_cast<double>(targetVertices) / 6.0)) + 1;
+		auto at = [side](uint32_t x, uint32_t y) {
+			glm::vec2 uv(static_cast<float>(x) / side, static_cast<float>(y) / side);
+			float height = std::sin(uv.x * 20.0f) * std::cos(uv.y * 20.0f);
+			return makeVertex(glm::vec3(uv.x, height, uv.y), glm::normalize(glm::vec3(-uv.x, 1.0f, -uv.y)), uv);
+		};
+		std::vector<Vertex> soup;
+		soup.reserve(static_cast<size_t>(side) * side * 6);
+		for (uint32_t y = 0; y < side && soup.size() < targetVertices; y++) {
+			for (uint32_t x = 0; x < side; x++) {
+				for (glm::uvec2 corner : { glm::uvec2(0, 0), glm::uvec2(1, 0), glm::uvec2(1, 1), glm::uvec2(0, 0), glm::uvec2(1, 1), glm::uvec2(0, 1) }) {
+					soup.emplace_back(at(x + corner.x, y + corner.y));
+				}
+			}
+		}
+		return soup;
+	}
+
+	//flat shaded boxes, every corner position is shared by three faces with different normals, the case the
+	//position-only std::hash<Vertex> collided on
+	std::vector<Vertex> makeFlatBoxes(size_t targetVertices) {
+		static const glm::vec3 normals[6] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+		std::vector<Vertex> soup;
+		soup.reserve(targetVertices + 36);
+		for (uint32_t box = 0; soup.size() < targetVertices; box++) {
+			glm::vec3 center(static_cast<float>(box % 1024), static_cast<float>(box / 1024), 0.0f);
+			for (const glm::vec3& normal : normals) {
+				glm::vec3 u = glm::vec3(normal.y != 0.0f ? 1.0f : 0.0f, normal.y == 0.0f ? 1.0f : 0.0f, 0.0f);
+				glm::vec3 v = glm::cross(normal, u);
+				glm::vec3 corners[4] = { normal - u - v, normal + u - v, normal + u + v, normal - u + v };
+				for (uint32_t corner : { 0, 1, 2, 0, 2, 3 }) soup.emplace_back(makeVertex(center + corners[corner] * 0.5f, normal, glm::vec2(0.0f)));
+			}
+		}
+		return soup;
+	}
+
+	//nothing to weld, every vertex is unique
+	std::vector<Vertex> makeUnique(size_t targetVertices) {
+		std::mt19937 rng(4);
+		std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+		std::vector<Vertex> soup(targetVertices);
+		for (Vertex& vertex : soup) vertex = makeVertex(glm::vec3(dist(rng), dist(rng), dist(rng)), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(dist(rng), dist(rng)));
+		return soup;
+	}
+
+	// ================================================================================================
+	// WELDERS
+	// ================================================================================================
+
+	//Mesh::toIndexed before weldVertices, kept as the baseline
+	uint32_t weldUnorderedMap(Vertex* vertices, uint32_t count, Index* indicesOut) {
+		std::vector<Vertex> unique;
+		std::unordered_map<Vertex, Index> duplicateCheck{};
+		for (uint32_t i = 0; i < count; i++) {
+			const Vertex& vertex = vertices[i];
+			if (!duplicateCheck.count(vertex)) {
+				duplicateCheck.insert({ vertex, static_cast<Index>(unique.size()) });
+				indicesOut[i] = static_cast<Index>(unique.size());
+				unique.emplace_back(vertex);
+			}
+			else {
+				indicesOut[i] = duplicateCheck[vertex];
+			}
+		}
+		std::copy(unique.begin(), unique.end(), vertices);
+		return static_cast<uint32_t>(unique.size());
+	}
+
+	struct Welder {
+		const char* name;
+		std::function<uint32_t(Vertex* vertices, uint32_t count, Index* indicesOut, const BenchOptions& options)> run;
+	};
+
+	const std::vector<Welder> WELDERS = {
+		{ "unordered_map", [](Vertex* vertices, uint32_t count, Index* indicesOut, const BenchOptions&) {
+			return weldUnorderedMap(vertices, count, indicesOut);
+		} },
+		{ "weld", [](Vertex* vertices, uint32_t count, Index* indicesOut, const BenchOptions&) {
+			return weldVertices(vertices, count, indicesOut, 1);
+		} },
+		{ "weld-parallel", [](Vertex* vertices, uint32_t count, Index* indicesOut, const BenchOptions& options) {
+			return weldVertices(vertices, count, indicesOut, resolveThreadCount(options.threads));
+		} },
+	};
+
+	void runSoup(const char* soupName, const std::vector<Vertex>& soup, const BenchOptions& options) {
+		const uint32_t count = static_cast<uint32_t>(soup.size());
+		std::cout << "\n" << soupName << " (" << count << " vertices)\n";
+		std::vector<Vertex> vertices;
+		std::vector<Index> indices(count);
+		std::vector<Vertex> expectedVertices;
+		std::vector<Index> expectedIndices;
+		for (const Welder& welder : WELDERS) {
+			double bestSeconds = std::numeric_limits<double>::max();
+			size_t allocations = 0;
+			uint32_t numUnique = 0;
+			for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+				vertices = soup;
+				const AllocationCounts startAllocations = allocationCounts();
+				auto start = std::chrono::steady_clock::now();
+				numUnique = welder.run(vertices.data(), count, indices.data(), options);
+				auto end = std::chrono::steady_clock::now();
+				bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(end - start).count());
+				allocations = allocationCounts().count - startAllocations.count;
+			}
+			vertices.resize(numUnique);
+
+			//the first welder is the reference the others must match exactly
+			bool matches = true;
+			if (expectedVertices.empty()) {
+				expectedVertices = vertices;
+				expectedIndices = indices;
+			}
+			else {
+				matches = vertices.size() == expectedVertices.size() && indices == expectedIndices &&
+					std::memcmp(vertices.data(), expectedVertices.data(), vertices.size() * sizeof(Vertex)) == 0;
+			}
+
+			std::cout << "  " << std::left << std::setw(14) << welder.name << std::right
+				<< std::setw(10) << std::fixed << std::setprecision(1) << static_cast<double>(count) / bestSeconds / 1e6 << " Mverts/s"
+				<< std::setw(12) << allocations << " allocs"
+				<< std::setw(12) << numUnique << " unique"
+				<< (matches ? "" : "   MISMATCH") << "\n";
+		}
+	}
+
+	size_t readSizeArg(int argc, char* argv[], int& argIdx) {
+		if (argIdx + 1 >= argc) throw std::runtime_error(std::string("missing value for ") + argv[argIdx]);
+		return static_cast<size_t>(std::stoul(argv[++argIdx]));
+	}
+}
+
+int main(int argc, char* argv[]) {
+	BenchOptions options{};
+	try {
+		for (int argIdx = 1; argIdx < argc; argIdx++) {
+			const std::string arg = argv[argIdx];
+			if (arg == "--vertices") options.vertices = std::max<size_t>(1, readSizeArg(argc, argv, argIdx));
+			else if (arg == "--iterations") options.iterations = std::max<size_t>(1, readSizeArg(argc, argv, argIdx));
+			else if (arg == "--threads") options.threads = static_cast<int>(readSizeArg(argc, argv, argIdx));
+			else throw std::runtime_error("unknown argument " + arg);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << "\nusage : real_bench_weld [--vertices {n}] [--iterations {n}] [--threads {n}]" << std::endl;
+		return 1;
+	}
+
+	std::cout << "vertex weld benchmark, " << options.iterations << " iterations, best time reported, "
+		<< resolveThreadCount(options.threads) << " threads for weld-parallel, " << sizeof(Index) * 8 << " bit indices\n";
+
+	runSoup("smooth grid", makeSmoothGrid(options.vertices), options);
+	runSoup("flat boxes", makeFlatBoxes(options.vertices), options);
+	runSoup("unique", makeUnique(options.vertices), options);
+	return 0;
+}
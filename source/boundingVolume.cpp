@@ -0,0 +1,139 @@
+#include "boundingVolume.hpp"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace {
+	//eigenvectors of the symmetric matrix m as the columns of vectors, by cyclic Jacobi rotations
+	void symmetricEigenvectors(double m[3][3], double vectors[3][3]) {
+		for (uint32_t i = 0; i < 3; i++) {
+			for (uint32_t j = 0; j < 3; j++) vectors[i][j] = i == j ? 1.0 : 0.0;
+		}
+		for (uint32_t sweep = 0; sweep < 32; sweep++) {
+			const double offDiagonal = m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+			const double diagonal = m[0][0] * m[0][0] + m[1][1] * m[1][1] + m[2][2] * m[2][2];
+			if (!(offDiagonal > 1e-24 * diagonal)) break;
+			for (uint32_t p = 0; p < 2; p++) {
+				for (uint32_t q = p + 1; q < 3; q++) {
+					if (m[p][q] == 0.0) continue;
+					//rotation in the pq plane that zeroes m[p][q]
+					const double theta = (m[q][q] - m[p][p]) / (2.0 * m[p][q]);
+					const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+					const double c = 1.0 / std::sqrt(t * t + 1.0), s = t * c;
+					for (uint32_t k = 0; k < 3; k++) {
+						const double mkp = m[k][p], mkq = m[k][q];
+						m[k][p] = c * mkp - s * mkq;
+						m[k][q] = s * mkp + c * mkq;
+					}
+					for (uint32_t k = 0; k < 3; k++) {
+						const double mpk = m[p][k], mqk = m[q][k];
+						m[p][k] = c * mpk - s * mqk;
+						m[q][k] = s * mpk + c * mqk;
+					}
+					for (uint32_t k = 0; k < 3; k++) {
+						const double vkp = vectors[k][p], vkq = vectors[k][q];
+						vectors[k][p] = c * vkp - s * vkq;
+						vectors[k][q] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+	}
+
+	//box along axes around the vertices, its volume in volumeOut
+	OrientedBounds fitAlong(const Vertex* vertices, uint32_t numVertices, const glm::vec3 axes[3], float minHalfExtent, double& volumeOut) {
+		glm::vec3 low = glm::vec3(std::numeric_limits<float>::max()), high = glm::vec3(-std::numeric_limits<float>::max());
+		for (uint32_t v = 0; v < numVertices; v++) {
+			const glm::vec3 projected = glm::vec3(glm::dot(vertices[v].position, axes[0]), glm::dot(vertices[v].position, axes[1]), glm::dot(vertices[v].position, axes[2]));
+			low = glm::min(low, projected);
+			high = glm::max(high, projected);
+		}
+		OrientedBounds box{};
+		const glm::vec3 middle = (low + high) * 0.5f;
+		box.center = axes[0] * middle.x + axes[1] * middle.y + axes[2] * middle.z;
+		box.halfExtents = glm::max((high - low) * 0.5f, glm::vec3(minHalfExtent));
+		std::copy(axes, axes + 3, box.axes);
+		volumeOut = double(box.halfExtents.x) * box.halfExtents.y * box.halfExtents.z;
+		return box;
+	}
+}
+
+BoundingSphere fitBoundingSphere(const Vertex* vertices, uint32_t numVertices) {
+	BoundingSphere sphere{};
+	if (numVertices == 0) return sphere;
+
+	//sphere around the axis aligned box
+	glm::vec3 low = vertices[0].position, high = vertices[0].position;
+	for (uint32_t v = 1; v < numVertices; v++) {
+		low = glm::min(low, vertices[v].position);
+		high = glm::max(high, vertices[v].position);
+	}
+	BoundingSphere boxSphere{ (low + high) * 0.5f, 0.0f };
+	for (uint32_t v = 0; v < numVertices; v++) boxSphere.radius = std::max(boxSphere.radius, glm::length(vertices[v].position - boxSphere.center));
+
+	//Ritter, starting from two roughly furthest apart vertices and growing to take in any left outside
+	auto furthestFrom = [&](glm::vec3 p) {
+		uint32_t furthest = 0;
+		float furthestDistance = -1.0f;
+		for (uint32_t v = 0; v < numVertices; v++) {
+			float distance = glm::dot(vertices[v].position - p, vertices[v].position - p);
+			if (distance > furthestDistance) {
+				furthest = v;
+				furthestDistance = distance;
+			}
+		}
+		return vertices[furthest].position;
+	};
+	const glm::vec3 a = furthestFrom(vertices[0].position);
+	const glm::vec3 b = furthestFrom(a);
+	sphere.center = (a + b) * 0.5f;
+	sphere.radius = glm::length(b - a) * 0.5f;
+	for (uint32_t v = 0; v < numVertices; v++) {
+		const float distance = glm::length(vertices[v].position - sphere.center);
+		if (distance <= sphere.radius) continue;
+		const float radius = (sphere.radius + distance) * 0.5f;
+		sphere.center += (vertices[v].position - sphere.center) * ((radius - sphere.radius) / distance);
+		sphere.radius = radius;
+	}
+	//the float updates can leave a vertex just outside
+	for (uint32_t v = 0; v < numVertices; v++) sphere.radius = std::max(sphere.radius, glm::length(vertices[v].position - sphere.center));
+
+	return sphere.radius < boxSphere.radius ? sphere : boxSphere;
+}
+
+OrientedBounds fitOrientedBounds(const Vertex* vertices, uint32_t numVertices, float minHalfExtent) {
+	const glm::vec3 meshAxes[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+	double meshVolume = 0.0;
+	OrientedBounds meshBox = fitAlong(vertices, numVertices, meshAxes, minHalfExtent, meshVolume);
+	if (numVertices < 3) return meshBox;
+
+	//covariance of the vertex positions
+	glm::dvec3 mean = glm::dvec3(0.0);
+	for (uint32_t v = 0; v < numVertices; v++) mean += glm::dvec3(vertices[v].position);
+	mean /= double(numVertices);
+	double covariance[3][3] = {};
+	for (uint32_t v = 0; v < numVertices; v++) {
+		const glm::dvec3 d = glm::dvec3(vertices[v].position) - mean;
+		for (uint32_t i = 0; i < 3; i++) {
+			for (uint32_t j = i; j < 3; j++) covariance[i][j] += d[i] * d[j];
+		}
+	}
+	covariance[1][0] = covariance[0][1];
+	covariance[2][0] = covariance[0][2];
+	covariance[2][1] = covariance[1][2];
+
+	double eigenvectors[3][3];
+	symmetricEigenvectors(covariance, eigenvectors);
+	glm::vec3 principalAxes[3];
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		principalAxes[axis] = glm::normalize(glm::vec3(float(eigenvectors[0][axis]), float(eigenvectors[1][axis]), float(eigenvectors[2][axis])));
+	}
+	//rebuilt from the first two so float rounding can't leave them skewed
+	principalAxes[1] = glm::normalize(principalAxes[1] - principalAxes[0] * glm::dot(principalAxes[0], principalAxes[1]));
+	principalAxes[2] = glm::cross(principalAxes[0], principalAxes[1]);
+	if (!std::isfinite(principalAxes[2].x) || !std::isfinite(principalAxes[2].y) || !std::isfinite(principalAxes[2].z)) return meshBox;
+
+	double principalVolume = 0.0;
+	OrientedBounds principalBox = fitAlong(vertices, numVertices, principalAxes, minHalfExtent, principalVolume);
+	return principalVolume < meshVolume ? principalBox : meshBox;
+}
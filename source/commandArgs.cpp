@@ -30,13 +30,21 @@ ParamMap commandLineParameters = { {
 		{"stripify", false},
 		{"cluster", false},
 		{"cluster-size", static_cast<int>(64)},
+		{"lod-levels", static_cast<int>(1)},
 		{"debug-level", static_cast<int>(0)},
 		{"separate-queue-families", false},
 		{"print-debug-output", false},
 		{"swapchain-mode", "mailbox"},
 		{"force-show-fps", false},
 		{"combined-vertex-index", false},
-		{"enable-debug-view", false}
+		{"enable-debug-view", false},
+		{"load-threads", static_cast<int>(0)},
+		{"no-scene-cache", false},
+		{"stream-meshes", false},
+		{"hot-reload", false},
+		{"optimize-vertex-cache", false},
+		{"vertex-layout", "full"},
+		{"split-positions", false}
 	}
 };
 
@@ -81,6 +89,7 @@ ModeConstantParameters ParamMap::toModeParameters() {
 	modeParameters.STRIPIFY = getBool("stripify");
 	modeParameters.CLUSTER = getBool("cluster");
 	modeParameters.CLUSTER_SIZE = getInt("cluster-size");
+	modeParameters.LOD_LEVELS = getInt("lod-levels");
 #if defined(NDEBUG) && NDEBUG
 	modeParameters.DEBUG = false;
 #else
@@ -89,6 +98,13 @@ ModeConstantParameters ParamMap::toModeParameters() {
 	modeParameters.PRINT_DEBUG_OUTPUT = getBool("print-debug-output");
 	modeParameters.DEBUG_LEVEL = getInt("debug-level");
 	modeParameters.ENABLE_DEBUG_VIEW = getBool("enable-debug-view");
+	modeParameters.LOAD_THREADS = getInt("load-threads");
+	modeParameters.SCENE_CACHE = !getBool("no-scene-cache");
+	modeParameters.STREAM_MESHES = getBool("stream-meshes");
+	modeParameters.HOT_RELOAD = getBool("hot-reload");
+	modeParameters.OPTIMIZE_VERTEX_CACHE = getBool("optimize-vertex-cache");
+	modeParameters.VERTEX_LAYOUT = getString("vertex-layout");
+	modeParameters.SPLIT_POSITIONS = getBool("split-positions");
 	return modeParameters;
 }
 
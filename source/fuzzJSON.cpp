@@ -0,0 +1,418 @@
+// libFuzzer entry point for JSONParser, built as real_fuzz_json when configured with -DJSON_FUZZ=ON (clang or MSVC)
+// the parser only accepts the subset of JSON found in .s72 files and asserts on anything else, so fuzz input is not
+// parsed directly. it drives a generator that writes a valid document of nested values, odd whitespace runs and
+// escaped strings, which is then parsed with every mode. all of them must agree with what was generated
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "jsonParsing.hpp"
+
+namespace {
+	constexpr size_t MAX_DEPTH = 24;
+	constexpr size_t MAX_ELEMENTS = 12;
+
+	struct ByteReader {
+		const uint8_t* data;
+		size_t size;
+		size_t pos = 0;
+
+		//zeros once the input runs out, which always picks the smallest choice so generation terminates
+		uint8_t next() { return pos < size ? data[pos++] : 0; }
+	};
+
+	// ================================================================================================
+	// CANONICAL FORM : every mode is reduced to the same string, object members sorted by key
+	// ================================================================================================
+
+	std::string canonicalNumber(float value) {
+		if (value == 0.0f) value = 0.0f; //-0 from a float array and 0 from an int are the same value
+		char buffer[32];
+		int length = std::snprintf(buffer, sizeof(buffer), "n%.9g", value);
+		return std::string(buffer, length);
+	}
+
+	//integers keep every digit, so a float rounding one of them shows up as a mismatch
+	std::string canonicalExact(const Number& number) {
+		if (number.type != INT) return canonicalNumber(number.toFloatDestructive());
+		return "i" + (number.negative ? std::to_string(number.toInt()) : std::to_string(number.toSizeT()));
+	}
+
+	std::string canonicalString(std::string_view str) {
+		return "s" + std::to_string(str.size()) + ":" + std::string(str);
+	}
+
+	std::string canonicalArray(const std::vector<std::string>& elements) {
+		std::string out = "[";
+		for (size_t e = 0; e < elements.size(); e++) out += (e > 0 ? "," : "") + elements[e];
+		return out + "]";
+	}
+
+	std::string canonicalObject(std::vector<std::string> members) {
+		std::sort(members.begin(), members.end());
+		std::string out = "{";
+		for (size_t m = 0; m < members.size(); m++) out += (m > 0 ? "," : "") + members[m];
+		return out + "}";
+	}
+
+	std::string canonicalMember(std::string_view key, const std::string& value) {
+		return canonicalString(key) + "=" + value;
+	}
+
+	// ================================================================================================
+	// GENERATOR
+	// ================================================================================================
+
+	void generateWhitespace(ByteReader& reader, std::string& out) {
+		uint8_t choice = reader.next();
+		if (choice < 192) return;
+		//long runs move the following token across stage-1 block boundaries
+		size_t run = (choice & 0x3F) + 1;
+		for (size_t w = 0; w < run; w++) out += " \n\t\r"[(choice + w) & 3];
+	}
+
+	//raw string contents, escapes are kept as written since the parser does not decode them
+	std::string generateString(ByteReader& reader) {
+		static const char* const PIECES[] = { "a", "Z", "0", " ", "{", "}", "[", "]", ",", ":", "-", "\\\"", "\\\\", "\\n", "\\/", "\\u00af", "e", "\xc3\xa9" };
+		constexpr size_t PIECE_COUNT = sizeof(PIECES) / sizeof(PIECES[0]);
+		std::string str;
+		size_t length = reader.next() % 16;
+		for (size_t c = 0; c < length; c++) str += PIECES[reader.next() % PIECE_COUNT];
+		return str;
+	}
+
+	//text of a number the parser accepts, exponents always carry a sign
+	std::string generateNumber(ByteReader& reader) {
+		uint8_t kind = reader.next() % 4;
+		uint32_t whole = (static_cast<uint32_t>(reader.next()) << 8 | reader.next()) % 100000;
+		std::string out = (kind & 1) ? "-" : "";
+		out += std::to_string(whole);
+		if (kind >= 2) {
+			out += "." + std::to_string(reader.next());
+			uint8_t exponent = reader.next();
+			if (exponent & 0x80) out += std::string((exponent & 0x40) ? "e-" : "E+") + std::to_string(exponent % 20);
+		}
+		return out;
+	}
+
+	//numeric array of integers from 2^24 on, which a float would round, with the odd float between them
+	//appends the document text to out and returns its canonical form with exact integers, see canonicalExact
+	std::string generateLargeIntegers(ByteReader& reader, std::string& out) {
+		out += "[";
+		std::vector<std::string> elements;
+		size_t count = reader.next() % MAX_ELEMENTS + 1;
+		for (size_t e = 0; e < count; e++) {
+			if (e > 0) out += ",";
+			generateWhitespace(reader, out);
+			uint8_t kind = reader.next() % 4;
+			if (kind == 3) {
+				std::string number = std::to_string(reader.next()) + ".5";
+				out += number;
+				elements.emplace_back(canonicalNumber(std::strtof(number.c_str(), nullptr)));
+				continue;
+			}
+			uint64_t magnitude = (uint64_t(1) << 24) + (uint64_t(reader.next()) << 16 | uint64_t(reader.next()) << 8 | reader.next());
+			if (kind == 2) magnitude <<= 8; //past 2^32, only unsigned integers are parsed that large
+			std::string number = (kind == 1 ? "-" : "") + std::to_string(magnitude);
+			out += number;
+			elements.emplace_back("i" + number);
+		}
+		generateWhitespace(reader, out);
+		out += "]";
+		return canonicalArray(elements);
+	}
+
+	//appends the document text to out and returns its canonical form
+	std::string generateValue(ByteReader& reader, std::string& out, size_t depth) {
+		generateWhitespace(reader, out);
+		uint8_t choice = reader.next() % 8;
+		if (depth >= MAX_DEPTH && (choice == 0 || choice == 1 || choice == 7)) choice = 2;
+
+		std::string canonical;
+		switch (choice) {
+		case 0: {
+			out += "{";
+			std::vector<std::string> members;
+			size_t count = reader.next() % MAX_ELEMENTS;
+			for (size_t m = 0; m < count; m++) {
+				if (m > 0) out += ",";
+				generateWhitespace(reader, out);
+				//index prefix keeps keys unique (no piece contains _), the DOM would otherwise keep only one of them
+				std::string key = std::to_string(m) + "_" + generateString(reader);
+				out += "\"" + key + "\"";
+				generateWhitespace(reader, out);
+				out += ":";
+				members.emplace_back(canonicalMember(key, generateValue(reader, out, depth + 1)));
+			}
+			generateWhitespace(reader, out);
+			out += "}";
+			canonical = canonicalObject(std::move(members));
+			break;
+		}
+		case 1: {
+			out += "[";
+			std::vector<std::string> elements;
+			size_t count = reader.next() % MAX_ELEMENTS;
+			for (size_t e = 0; e < count; e++) {
+				if (e > 0) out += ",";
+				elements.emplace_back(generateValue(reader, out, depth + 1));
+			}
+			generateWhitespace(reader, out);
+			out += "]";
+			canonical = canonicalArray(elements);
+			break;
+		}
+		case 2: {
+			std::string number = generateNumber(reader);
+			out += number;
+			canonical = canonicalNumber(std::strtof(number.c_str(), nullptr));
+			break;
+		}
+		case 3: {
+			std::string str = generateString(reader);
+			out += "\"" + str + "\"";
+			canonical = canonicalString(str);
+			break;
+		}
+		case 4: out += "true"; canonical = "t"; break;
+		case 5: out += "false"; canonical = "f"; break;
+		case 6: out += "null"; canonical = "z"; break;
+		default: {
+			//numeric array, the float fast paths of the tape and cursor APIs
+			out += "[";
+			std::vector<std::string> elements;
+			size_t count = reader.next() % (MAX_ELEMENTS * 4);
+			for (size_t e = 0; e < count; e++) {
+				if (e > 0) out += ",";
+				generateWhitespace(reader, out);
+				std::string number = generateNumber(reader);
+				out += number;
+				elements.emplace_back(canonicalNumber(std::strtof(number.c_str(), nullptr)));
+			}
+			generateWhitespace(reader, out);
+			out += "]";
+			canonical = canonicalArray(elements);
+		}
+		}
+		generateWhitespace(reader, out);
+		return canonical;
+	}
+
+	// ================================================================================================
+	// PARSER MODES
+	// ================================================================================================
+
+	std::string fromDOM(const Value& value) {
+		switch (value.type) {
+		case OBJECT: {
+			std::vector<std::string> members;
+			for (const auto& [key, member] : value.toObject()) members.emplace_back(canonicalMember(key, fromDOM(member)));
+			return canonicalObject(std::move(members));
+		}
+		case ARRAY: {
+			std::vector<std::string> elements;
+			for (const Value& element : value.toArray()) elements.emplace_back(fromDOM(element));
+			return canonicalArray(elements);
+		}
+		case NUMBER: return canonicalNumber(value.toNumber().toFloatDestructive());
+		case STRING: return canonicalString(value.toString());
+		case BOOL: return std::get<bool>(value) ? "t" : "f";
+		default: return "z";
+		}
+	}
+
+	std::string fromTape(TapeRef ref) {
+		switch (ref.type()) {
+		case OBJECT: {
+			std::vector<std::string> members;
+			for (TapeRef member : ref) members.emplace_back(canonicalMember(member.key(), fromTape(member)));
+			return canonicalObject(std::move(members));
+		}
+		case ARRAY: {
+			std::vector<std::string> elements;
+			if (ref.isFloatArray()) {
+				for (float value : ref.toFloats()) elements.emplace_back(canonicalNumber(value));
+			}
+			else {
+				for (TapeRef element : ref) elements.emplace_back(fromTape(element));
+			}
+			return canonicalArray(elements);
+		}
+		case NUMBER: return canonicalNumber(ref.toNumber().toFloatDestructive());
+		case STRING: return canonicalString(ref.toString());
+		case BOOL: return ref.toBool() ? "t" : "f";
+		default: return "z";
+		}
+	}
+
+	//numeric array read with canonicalExact, see generateLargeIntegers
+	std::string fromTapeExact(TapeRef ref) {
+		std::vector<std::string> elements;
+		if (ref.isFloatArray()) {
+			for (float value : ref.toFloats()) elements.emplace_back(canonicalNumber(value));
+		}
+		else {
+			for (TapeRef element : ref) elements.emplace_back(canonicalExact(element.toNumber()));
+		}
+		return canonicalArray(elements);
+	}
+
+	struct CanonicalHandler : JSONHandler {
+		struct Frame {
+			bool isObject;
+			std::string_view key{};
+			std::vector<std::string> parts{};
+		};
+		std::vector<Frame> stack{};
+		std::string result{};
+
+		void add(std::string canonical) {
+			if (stack.empty()) {
+				result = std::move(canonical);
+				return;
+			}
+			Frame& top = stack.back();
+			top.parts.emplace_back(top.isObject ? canonicalMember(top.key, canonical) : std::move(canonical));
+		}
+
+		void startObject() override { stack.push_back(Frame{ true }); }
+		void key(std::string_view keyName) override { stack.back().key = keyName; }
+		void endObject(uint32_t members) override {
+			Frame frame = std::move(stack.back());
+			stack.pop_back();
+			if (frame.parts.size() != members) std::abort();
+			add(canonicalObject(std::move(frame.parts)));
+		}
+		void startArray() override { stack.push_back(Frame{ false }); }
+		void endArray(uint32_t elements) override {
+			Frame frame = std::move(stack.back());
+			stack.pop_back();
+			if (frame.parts.size() != elements) std::abort();
+			add(canonicalArray(frame.parts));
+		}
+		void number(const Number& number) override { add(canonicalNumber(number.toFloatDestructive())); }
+		void string(std::string_view str) override { add(canonicalString(str)); }
+		void boolean(bool boolean) override { add(boolean ? "t" : "f"); }
+		void null() override { add("z"); }
+	};
+
+	//same order of calls as the typed .s72 decoders, numeric arrays go through readFloats first
+	std::string fromCursor(JSONParser& parser) {
+		switch (parser.peekType()) {
+		case OBJECT: {
+			std::vector<std::string> members;
+			parser.beginObject();
+			std::string_view key;
+			while (parser.nextMember(key)) members.emplace_back(canonicalMember(key, fromCursor(parser)));
+			return canonicalObject(std::move(members));
+		}
+		case ARRAY: {
+			std::vector<std::string> elements;
+			std::vector<float> floats;
+			if (parser.readFloats(floats)) {
+				for (float value : floats) elements.emplace_back(canonicalNumber(value));
+			}
+			else {
+				parser.beginArray();
+				while (parser.nextElement()) elements.emplace_back(fromCursor(parser));
+			}
+			return canonicalArray(elements);
+		}
+		case NUMBER: return canonicalNumber(parser.readNumber().toFloatDestructive());
+		case STRING: return canonicalString(parser.readString());
+		case BOOL: return parser.readBool() ? "t" : "f";
+		default:
+			parser.skipValue();
+			return "z";
+		}
+	}
+
+	void check(const char* mode, const std::string& expected, const std::string& actual, const std::string& document) {
+		if (expected == actual) return;
+		std::fprintf(stderr, "%s mismatch\ndocument : %s\nexpected : %s\nactual   : %s\n", mode, document.c_str(), expected.c_str(), actual.c_str());
+		std::abort();
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	ByteReader reader{ data, size };
+	std::string document;
+	//the parser needs a container at the top level, like every .s72 file
+	const bool topLevelArray = reader.next() & 1;
+	std::vector<std::string> elements;
+	std::string expected;
+	if (topLevelArray) {
+		document = "[";
+		size_t count = reader.next() % (MAX_ELEMENTS * 2);
+		for (size_t e = 0; e < count; e++) {
+			if (e > 0) document += ",";
+			elements.emplace_back(generateValue(reader, document, 1));
+		}
+		document += "]";
+		expected = canonicalArray(elements);
+	}
+	else {
+		document = "{\"key\":";
+		expected = canonicalObject({ canonicalMember("key", generateValue(reader, document, 1)) });
+		document += "}";
+	}
+	generateWhitespace(reader, document);
+
+	{
+		JSONParser parser(document);
+		check("dom", expected, fromDOM(parser.parse()), document);
+	}
+	{
+		JSONParser parser(document);
+		JSONTape tape = parser.parseTape();
+		check("tape", expected, fromTape(tape.root()), document);
+	}
+	{
+		JSONParser parser(document);
+		CanonicalHandler handler;
+		parser.parseEvents(handler);
+		check("events", expected, handler.result, document);
+	}
+	{
+		JSONParser parser(document);
+		check("cursor", expected, fromCursor(parser), document);
+	}
+	{
+		//skipping every top-level value must land on the same boundaries parsing does
+		JSONParser parser(document);
+		size_t skipped = 0;
+		if (topLevelArray) {
+			parser.beginArray();
+			for (; parser.nextElement(); skipped++) parser.skipValue();
+		}
+		else {
+			parser.beginObject();
+			std::string_view key;
+			for (; parser.nextMember(key); skipped++) parser.skipValue();
+		}
+		check("skip", std::to_string(topLevelArray ? elements.size() : 1), std::to_string(skipped), document);
+	}
+	if (topLevelArray) {
+		JSONParser parser(document);
+		parser.beginArray();
+		std::vector<JSONParser> ranges = parser.splitArray(reader.next() % 8 + 1);
+		std::vector<std::string> rangeElements;
+		for (JSONParser& range : ranges) {
+			while (range.nextElement()) rangeElements.emplace_back(fromCursor(range));
+		}
+		check("splitArray", expected, canonicalArray(rangeElements), document);
+	}
+	{
+		//integers a float would round must stay out of the tape's float storage
+		std::string integers;
+		std::string integersExpected = generateLargeIntegers(reader, integers);
+		JSONParser parser(integers);
+		JSONTape tape = parser.parseTape();
+		check("tape integers", integersExpected, fromTapeExact(tape.root()), integers);
+	}
+	return 0;
+}
@@ -1,32 +1,25 @@
 #include "jsonParsing.hpp"
-#include <fstream>
+#include "jsonStructural.hpp"
 #include <iostream>
 #include <string>
-#include <sstream>
 #include <cassert>
+#include <charconv>
+#include <cmath>
 
 namespace {
     const bool CHECK_VALIDITY = true;
     const bool DEBUG = false;
+    //2^24, integers from here on are not all exact as floats
+    const float FLOAT_INTEGER_LIMIT = 16777216.0f;
 }
 
 bool JSONParser::readJSONFile(std::string filename) {
-    std::ifstream jsonFile(filename);
-
-    if (!jsonFile.good()) {
+    //parse straight out of the mapped pages instead of copying the file into a string
+    if (!input.open(filename)) {
         return false;
     }
 
-    if (!jsonFile.is_open()) {
-        throw std::runtime_error("failed to open json file");
-    }
-
-    std::stringstream stream;
-    stream << jsonFile.rdbuf();
-
-    jsonFile.close();
-
-    file = stream.str();
+    file = std::string_view(input.data(), input.size());
 
     return true;
 }
@@ -42,19 +35,20 @@ char JSONParser::at(int j) {
 }
 
 void JSONParser::skipWhiteSpace() {
-    while (WHITESPACE.contains(at())) {
-        i++;
-    }
+    //jump straight to the next structural character or value start found in stage-1,
+    //i only ever moves forward so the cursor into structurals does too
+    while (structurals[structuralIdx] < i) structuralIdx++;
+    i = structurals[structuralIdx];
 }
 
 
 Object JSONParser::parseObject() {
     if (DEBUG) assert(at() == '{');
     i++;
+    skipWhiteSpace();
 
     Object retObject{};
     while (at() != '}') {
-        skipWhiteSpace();
         if (CHECK_VALIDITY) assert(at() == '"');
         std::string key = parseString();
         skipWhiteSpace();
@@ -62,14 +56,13 @@ Object JSONParser::parseObject() {
         i++;
         Value value = parseValue();
 
-        retObject.insert({ key, value });
+        retObject.emplace(std::move(key), std::move(value));
 
+        skipWhiteSpace();
         if (at() == ',') {
             i++;
-            if (CHECK_VALIDITY) assert(at() != '}');
-        }
-        else {
             skipWhiteSpace();
+            if (CHECK_VALIDITY) assert(at() != '}');
         }
     }
     i++;
@@ -96,97 +89,145 @@ Array JSONParser::parseArray() {
     return retArray;
 }
 
+void JSONParser::scanNumber(Number& number) {
+    //bounded by end rather than at(), a top-level number can run to the end of the document
+    const char* c = file.data() + i;
+    const char* end = file.data() + fileSize;
+    auto is = [&](JSONCharClass charClass) { return c < end && isJSONCharClass(*c, charClass); };
+    number.type = INT;
+    number.negative = *c == '-';
+    if (!CHECK_VALIDITY) {
+        for (; is(JSON_NUM_CHAR); c++) {
+            if (*c == '.') number.type = FLOAT;
+            else if (*c == 'e' || *c == 'E') number.type = EXPONENTIAL;
+        }
+        i = c - file.data();
+        return;
+    }
+
+    //-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    auto digits = [&]() {
+        assert(is(JSON_DIGIT_CHAR));
+        while (is(JSON_DIGIT_CHAR)) c++;
+    };
+    if (number.negative) c++;
+    if (c < end && *c == '0') c++;
+    else digits();
+    if (c < end && *c == '.') {
+        number.type = FLOAT;
+        c++;
+        digits();
+    }
+    if (c < end && (*c == 'e' || *c == 'E')) {
+        number.type = EXPONENTIAL;
+        c++;
+        if (c < end && (*c == '+' || *c == '-')) c++;
+        digits();
+    }
+    assert(!is(JSON_NUM_CHAR)); //no leading zeros, trailing . e E or stray + -
+    i = c - file.data();
+}
+
 Number JSONParser::parseNumber() {
     if (DEBUG) {
-        if (!DIGITS.contains(at()) && (at() != '-')) {
+        if (!isJSONCharClass(at(), JSON_DIGIT_CHAR) && (at() != '-')) {
             assert(false);
         }
     }
 
     Number retNumber{};
-    retNumber.type = INT;
-    std::string numString = "";
-    retNumber.negative = false;
-    if (!CHECK_VALIDITY) {
-        if (at() == '-') retNumber.negative = true;
-        while (NUM_CHARS.contains(at())) {
-            numString += at();
-            if (at() == '.') retNumber.type = FLOAT;
-            else if (at() == 'e' || at() == 'E') retNumber.type = EXPONENTIAL;
-            i++;
-        }
-    }
-    else {
-        [[maybe_unused]]
-        bool zeroPrefix = false;
-        size_t lastI = i;
-        while (NUM_CHARS.contains(at())) {
-            numString += at();
-            if (at() == '-') {
-                assert(!retNumber.negative);
-                retNumber.negative = true;
-            }
-            else if (at() == 0 && lastI == i) {
-                zeroPrefix = true;
-            }
-            else if (at() == '.') {
-                assert(retNumber.type == INT && i != lastI);
-                retNumber.type = FLOAT;
-            }
-            else if (at() == 'e' || at() == 'E') {
-                assert(retNumber.type != EXPONENTIAL && i != lastI);
-                assert(at(1) == '+' || at(1) == '-');
-                retNumber.type = EXPONENTIAL;
-                i++;
-                numString += at();
-            }
-            else if (DEBUG) {
-                assert(DIGITS.contains(at()));
-            }
+    size_t start = i;
+    scanNumber(retNumber);
 
-            i++;
-        }
-        assert(DIGITS.contains(at(-1))); //does not end in ., e, E, -. +
+    //convert straight out of the file buffer, no temporary string
+    const char* first = file.data() + start;
+    const char* last = file.data() + i;
+    [[maybe_unused]]
+    std::from_chars_result result{};
+    if (retNumber.negative && retNumber.type == INT) {
+        int numI = 0;
+        result = std::from_chars(first, last, numI);
+        retNumber.val = numI;
     }
-
-    if (retNumber.negative && retNumber.type == INT) retNumber.val = stoi(numString);
     else if (retNumber.type == INT) {
-        std::stringstream stream(numString);
-        size_t numS;
-        stream >> numS;
+        size_t numS = 0;
+        result = std::from_chars(first, last, numS);
         retNumber.val = numS;
     }
-    else retNumber.val = stof(numString);
+    else {
+        float numF = 0.0f;
+        result = std::from_chars(first, last, numF);
+        retNumber.val = numF;
+    }
+    if (CHECK_VALIDITY) assert(result.ec == std::errc() && result.ptr == last);
 
     return retNumber;
 }
 
+bool JSONParser::parseFloatArray(std::vector<float>& floats, bool exactIntegers) {
+    size_t startI = i;
+    size_t startStructuralIdx = structuralIdx;
+    size_t startSize = floats.size();
+
+    while (isJSONCharClass(at(), JSON_DIGIT_CHAR) || at() == '-') {
+        const char* first = file.data() + i;
+        Number scanned{};
+        scanNumber(scanned);
+        float value = 0.0f;
+        std::from_chars_result result = std::from_chars(first, file.data() + i, value);
+        if (result.ec != std::errc() || result.ptr != file.data() + i) break;
+        if (exactIntegers && scanned.type == INT && std::abs(value) >= FLOAT_INTEGER_LIMIT) break;
+        floats.push_back(value);
+
+        skipWhiteSpace();
+        if (at() == ']') return true;
+        if (at() != ',') break;
+        i++;
+        skipWhiteSpace();
+    }
+
+    //not a homogeneous numeric array, rewind so the caller can parse it element by element
+    i = startI;
+    structuralIdx = startStructuralIdx;
+    floats.resize(startSize);
+    return false;
+}
+
 std::string JSONParser::parseString() {
+    return std::string(parseStringView());
+}
+
+std::string_view JSONParser::parseStringView() {
     if (DEBUG) assert(at() == '"');
-    std::string retString = "";
-    i++;
-    while (at() != '"') {
-        retString += at();
-        if (at() == '\\') {
-            i++;
-            retString += at();
-            if (!CHECK_VALIDITY) continue;
-            if (at() == 'u') {
-                for (size_t j = 0; j < 4; j++) {
-                    i++;
-                    assert(HEX_DIGITS.contains(at()));
-                    retString += at();
+    //stage-1 masks out everything inside strings, so the closing quote is the last
+    //non-whitespace character before the next structural index
+    while (structurals[structuralIdx] <= i) structuralIdx++;
+    size_t end = structurals[structuralIdx] - 1;
+    while (isJSONCharClass(file[end], JSON_WHITESPACE_CHAR)) end--;
+    if (CHECK_VALIDITY) assert(end > i && file[end] == '"');
+
+    size_t start = i + 1;
+    std::string_view retView(file.data() + start, end - start);
+    if (CHECK_VALIDITY && retView.find('\\') != std::string_view::npos) {
+        for (size_t j = 0; j < retView.size(); j++) {
+            if (retView[j] != '\\') continue;
+            j++;
+            assert(j < retView.size());
+            if (retView[j] == 'u') {
+                //all four hex digits must be inside the string, \u or \u12 at its end would read past it
+                assert(j + 4 < retView.size());
+                for (size_t k = 0; k < 4; k++) {
+                    j++;
+                    assert(HEX_DIGITS.contains(retView[j]));
                 }
             }
             else {
-                assert(ESCAPES.contains(at()));
+                assert(ESCAPES.contains(retView[j]));
             }
         }
-        i++;
     }
-    if (DEBUG) assert(at() == '"'); //sanity check
-    i++;
-    return retString;
+    i = end + 1;
+    return retView;
 }
 
 bool JSONParser::parseBool() {
@@ -197,7 +238,7 @@ bool JSONParser::parseBool() {
         return true;
     }
     else if (at() == 'f') {
-        if (CHECK_VALIDITY) assert(at(1) == 'a' && at(2) == 'l' && at(3) == 's' && at(5) == 'e');
+        if (CHECK_VALIDITY) assert(at(1) == 'a' && at(2) == 'l' && at(3) == 's' && at(4) == 'e');
         i += 5;
         return false;
     }
@@ -216,18 +257,15 @@ Value JSONParser::parseValue() {
     Value retVal{};
     skipWhiteSpace();
     if (at() == '{') {
-        Object retObject = parseObject();
-        retVal = retObject;
+        retVal = parseObject();
         retVal.type = OBJECT;
     }
     else if (at() == '[') {
-        Array retArray = parseArray();
-        retVal = retArray;
+        retVal = parseArray();
         retVal.type = ARRAY;
     }
     else if (at() == '"') {
-        std::string retString = parseString();
-        retVal = retString;
+        retVal = parseString();
         retVal.type = STRING;
     }
     else if (at() == 't' || at() == 'f') {
@@ -240,7 +278,7 @@ Value JSONParser::parseValue() {
         retVal = (retNull);
         retVal.type = NULLPTR;
     }
-    else if (DIGITS.contains(at()) || at() == '-') {
+    else if (isJSONCharClass(at(), JSON_DIGIT_CHAR) || at() == '-') {
         Number retNumber = parseNumber();
         retVal = retNumber;
         retVal.type = NUMBER;
@@ -257,6 +295,15 @@ JSONParser::JSONParser(std::string _filename, bool* fileGood) {
     *fileGood = readJSONFile(_filename);
 
     fileSize = file.size();
+    if (*fileGood) findStructurals(file.data(), fileSize, ownStructurals);
+    structurals = ownStructurals;
+}
+
+JSONParser::JSONParser(std::string_view buffer) {
+    file = buffer;
+    fileSize = file.size();
+    findStructurals(file.data(), fileSize, ownStructurals);
+    structurals = ownStructurals;
 }
 
 JSONParser::JSONParser() {
@@ -267,12 +314,422 @@ Value JSONParser::parse() {
     return parseValue();
 };
 
-Value JSONUtils::getVal(const Object& obj, std::string keyName, JSONDataType type, bool CHECK_VALIDITY) {
-    if (CHECK_VALIDITY && !obj.count(keyName)) {
+void JSONParser::parseTapeValue(JSONTape& tape, std::string_view key) {
+    skipWhiteSpace();
+    //tokens may reallocate while recursing, so only refer to this token by index
+    uint32_t tokenIdx = static_cast<uint32_t>(tape.tokens.size());
+    tape.tokens.emplace_back();
+    tape.tokens[tokenIdx].key = key;
+
+    if (at() == '{') {
+        tape.tokens[tokenIdx].type = OBJECT;
+        i++;
+        skipWhiteSpace();
+        uint32_t members = 0;
+        while (at() != '}') {
+            if (CHECK_VALIDITY) assert(at() == '"');
+            std::string_view memberKey = parseStringView();
+            skipWhiteSpace();
+            if (CHECK_VALIDITY) assert(at() == ':');
+            i++;
+            parseTapeValue(tape, memberKey);
+            members++;
+            skipWhiteSpace();
+            if (CHECK_VALIDITY) assert(at() == ',' || at() == '}');
+            if (at() == ',') {
+                i++;
+                skipWhiteSpace();
+                if (CHECK_VALIDITY) assert(at() != '}');
+            }
+        }
+        i++;
+        tape.tokens[tokenIdx].size = members;
+    }
+    else if (at() == '[') {
+        tape.tokens[tokenIdx].type = ARRAY;
+        i++;
+        skipWhiteSpace();
+        uint32_t floatsOffset = static_cast<uint32_t>(tape.floats.size());
+        if (parseFloatArray(tape.floats, true)) {
+            //numeric arrays (driver times / values, transforms, children) get no per-element tokens, unless they hold
+            //integers a float would round, which keep their exact Number tokens
+            tape.tokens[tokenIdx].floatArray = true;
+            tape.tokens[tokenIdx].floatsOffset = floatsOffset;
+            tape.tokens[tokenIdx].size = static_cast<uint32_t>(tape.floats.size()) - floatsOffset;
+            i++;
+        }
+        else {
+            uint32_t elements = 0;
+            while (at() != ']') {
+                parseTapeValue(tape, {});
+                elements++;
+                skipWhiteSpace();
+                if (CHECK_VALIDITY) assert(at() == ',' || at() == ']');
+                if (at() == ',') i++;
+            }
+            i++;
+            tape.tokens[tokenIdx].size = elements;
+        }
+    }
+    else if (at() == '"') {
+        tape.tokens[tokenIdx].type = STRING;
+        tape.tokens[tokenIdx].str = parseStringView();
+    }
+    else if (at() == 't' || at() == 'f') {
+        tape.tokens[tokenIdx].type = BOOL;
+        tape.tokens[tokenIdx].boolean = parseBool();
+    }
+    else if (at() == 'n') {
+        tape.tokens[tokenIdx].type = NULLPTR;
+        parseNull();
+    }
+    else if (isJSONCharClass(at(), JSON_DIGIT_CHAR) || at() == '-') {
+        tape.tokens[tokenIdx].type = NUMBER;
+        tape.tokens[tokenIdx].number = parseNumber();
+    }
+    else {
+        fprintf(stderr, "\nunaccounted for character : ---| %c |---\n", at());
+        throw std::runtime_error("");
+    }
+
+    tape.tokens[tokenIdx].end = static_cast<uint32_t>(tape.tokens.size());
+}
+
+JSONTape JSONParser::parseTape() {
+    JSONTape retTape{};
+    //rough guess of one token per 16 bytes of file, avoids most reallocations on .s72 files
+    retTape.tokens.reserve(fileSize / 16 + 1);
+    parseTapeValue(retTape, {});
+    return retTape;
+}
+
+void JSONParser::parseEventValue(JSONHandler& handler) {
+    skipWhiteSpace();
+    if (at() == '{') {
+        handler.startObject();
+        i++;
+        skipWhiteSpace();
+        uint32_t members = 0;
+        while (at() != '}') {
+            if (CHECK_VALIDITY) assert(at() == '"');
+            handler.key(parseStringView());
+            skipWhiteSpace();
+            if (CHECK_VALIDITY) assert(at() == ':');
+            i++;
+            parseEventValue(handler);
+            members++;
+            skipWhiteSpace();
+            if (CHECK_VALIDITY) assert(at() == ',' || at() == '}');
+            if (at() == ',') {
+                i++;
+                skipWhiteSpace();
+                if (CHECK_VALIDITY) assert(at() != '}');
+            }
+        }
+        i++;
+        handler.endObject(members);
+    }
+    else if (at() == '[') {
+        handler.startArray();
+        i++;
+        skipWhiteSpace();
+        uint32_t elements = 0;
+        while (at() != ']') {
+            parseEventValue(handler);
+            elements++;
+            skipWhiteSpace();
+            if (CHECK_VALIDITY) assert(at() == ',' || at() == ']');
+            if (at() == ',') i++;
+        }
+        i++;
+        handler.endArray(elements);
+    }
+    else if (at() == '"') {
+        handler.string(parseStringView());
+    }
+    else if (at() == 't' || at() == 'f') {
+        handler.boolean(parseBool());
+    }
+    else if (at() == 'n') {
+        parseNull();
+        handler.null();
+    }
+    else if (isJSONCharClass(at(), JSON_DIGIT_CHAR) || at() == '-') {
+        handler.number(parseNumber());
+    }
+    else {
+        fprintf(stderr, "\nunaccounted for character : ---| %c |---\n", at());
+        throw std::runtime_error("");
+    }
+}
+
+void JSONParser::parseEvents(JSONHandler& handler) {
+    parseEventValue(handler);
+}
+
+bool JSONParser::beginArray() {
+    skipWhiteSpace();
+    if (at() != '[') return false;
+    i++;
+    return true;
+}
+
+bool JSONParser::nextElement() {
+    skipWhiteSpace();
+    if (i == rangeEnd) return false;
+    if (at() == ',') {
+        i++;
+        skipWhiteSpace();
+        if (CHECK_VALIDITY) assert(at() != ']');
+    }
+    if (at() == ']') {
+        i++;
+        return false;
+    }
+    return true;
+}
+
+std::vector<JSONParser> JSONParser::splitArray(size_t maxRanges) {
+    skipWhiteSpace();
+    if (at() == ',') {
+        i++;
+        skipWhiteSpace();
+    }
+    //structural idx of the first structural of every remaining element, plus the closing ']'
+    std::vector<size_t> elementStarts{};
+    size_t depth = 0;
+    size_t idx = structuralIdx;
+    if (file[structurals[idx]] != ']') elementStarts.emplace_back(idx);
+    for (; idx < structurals.size() - 1; idx++) {
+        char c = file[structurals[idx]];
+        if (c == '{' || c == '[') depth++;
+        else if ((c == '}' || c == ']') && depth > 0) depth--;
+        else if (c == ']') break;
+        else if (c == ',' && depth == 0) elementStarts.emplace_back(idx + 1);
+    }
+    if (CHECK_VALIDITY) assert(idx < structurals.size() - 1 && file[structurals[idx]] == ']');
+    const size_t closeIdx = idx;
+
+    std::vector<JSONParser> ranges{};
+    if (elementStarts.empty() || maxRanges == 0) {
+        structuralIdx = closeIdx;
+        i = structurals[closeIdx];
+        return ranges;
+    }
+    //balance by bytes rather than element count, a single MESH or DRIVER can be far larger than a NODE
+    const size_t firstByte = structurals[elementStarts.front()];
+    const size_t totalBytes = structurals[closeIdx] - firstByte;
+    const size_t targetBytes = totalBytes / maxRanges + 1;
+    size_t rangeStart = 0;
+    while (rangeStart < elementStarts.size()) {
+        size_t rangeStop = rangeStart + 1;
+        const size_t rangeBytesEnd = structurals[elementStarts[rangeStart]] + targetBytes;
+        while (rangeStop < elementStarts.size() && structurals[elementStarts[rangeStop]] < rangeBytesEnd) rangeStop++;
+
+        JSONParser& range = ranges.emplace_back();
+        range.file = file;
+        range.fileSize = fileSize;
+        range.structurals = structurals;
+        range.structuralIdx = elementStarts[rangeStart];
+        range.i = structurals[range.structuralIdx];
+        //the ',' before the next range's first element, or the closing ']'
+        range.rangeEnd = rangeStop < elementStarts.size() ? structurals[elementStarts[rangeStop] - 1] : structurals[closeIdx];
+        rangeStart = rangeStop;
+    }
+
+    structuralIdx = closeIdx;
+    i = structurals[closeIdx];
+    return ranges;
+}
+
+bool JSONParser::nextElement(JSONTape& tape) {
+    tape.tokens.clear();
+    tape.floats.clear();
+    if (!nextElement()) return false;
+    parseTapeValue(tape, {});
+    return true;
+}
+
+bool JSONParser::nextElement(JSONHandler& handler) {
+    if (!nextElement()) return false;
+    parseEventValue(handler);
+    return true;
+}
+
+bool JSONParser::beginObject() {
+    skipWhiteSpace();
+    if (at() != '{') return false;
+    i++;
+    return true;
+}
+
+bool JSONParser::nextMember(std::string_view& key) {
+    skipWhiteSpace();
+    if (at() == ',') {
+        i++;
+        skipWhiteSpace();
+        if (CHECK_VALIDITY) assert(at() != '}');
+    }
+    if (at() == '}') {
+        i++;
+        return false;
+    }
+    if (CHECK_VALIDITY) assert(at() == '"');
+    key = parseStringView();
+    skipWhiteSpace();
+    if (CHECK_VALIDITY) assert(at() == ':');
+    i++;
+    return true;
+}
+
+JSONDataType JSONParser::peekType() {
+    skipWhiteSpace();
+    switch (at()) {
+    case '{': return OBJECT;
+    case '[': return ARRAY;
+    case '"': return STRING;
+    case 't': case 'f': return BOOL;
+    case 'n': return NULLPTR;
+    default: return isJSONCharClass(at(), JSON_DIGIT_CHAR) || at() == '-' ? NUMBER : MONOSTATE;
+    }
+}
+
+Number JSONParser::readNumber() {
+    skipWhiteSpace();
+    return parseNumber();
+}
+
+std::string_view JSONParser::readString() {
+    skipWhiteSpace();
+    if (CHECK_VALIDITY) assert(at() == '"');
+    return parseStringView();
+}
+
+bool JSONParser::readBool() {
+    skipWhiteSpace();
+    return parseBool();
+}
+
+bool JSONParser::readFloats(std::vector<float>& floats) {
+    size_t startI = i;
+    size_t startStructuralIdx = structuralIdx;
+    if (!beginArray()) return false;
+    skipWhiteSpace();
+    if (at() == ']') {
+        i++;
+        return true;
+    }
+    if (!parseFloatArray(floats)) {
+        i = startI;
+        structuralIdx = startStructuralIdx;
+        return false;
+    }
+    i++;
+    return true;
+}
+
+bool JSONParser::readFloats(float* floats, size_t count) {
+    if (!beginArray()) return false;
+    for (size_t j = 0; j < count; j++) {
+        [[maybe_unused]]
+        bool hasElement = nextElement();
+        if (CHECK_VALIDITY) assert(hasElement);
+        floats[j] = readNumber().toFloatDestructive();
+    }
+    [[maybe_unused]]
+    bool hasMore = nextElement();
+    if (CHECK_VALIDITY) assert(!hasMore);
+    return true;
+}
+
+void JSONParser::skipValue() {
+    skipWhiteSpace();
+    if (at() == '{' || at() == '[') {
+        //only brackets change depth, strings and scalars inside are never looked at
+        uint32_t depth = 0;
+        for (; structuralIdx < structurals.size(); structuralIdx++) {
+            char c = file[structurals[structuralIdx]];
+            if (c == '{' || c == '[') depth++;
+            else if (c == '}' || c == ']') depth--;
+            if (depth == 0) break;
+        }
+        if (CHECK_VALIDITY) assert(depth == 0);
+        i = structurals[structuralIdx] + 1;
+    }
+    else if (at() == '"') {
+        parseStringView();
+    }
+    else {
+        //scalar ends before the next structural
+        i = structurals[structuralIdx + 1];
+    }
+}
+
+std::string_view JSONParser::peekMemberString(std::string_view key) {
+    size_t startI = i;
+    size_t startStructuralIdx = structuralIdx;
+    std::string_view retView{};
+
+    if (beginObject()) {
+        std::string_view memberKey;
+        while (nextMember(memberKey)) {
+            if (memberKey == key && peekType() == STRING) {
+                retView = readString();
+                break;
+            }
+            skipValue();
+        }
+    }
+
+    i = startI;
+    structuralIdx = startStructuralIdx;
+    return retView;
+}
+
+TapeRef JSONTape::root() const {
+    return TapeRef{ this, 0 };
+}
+
+TapeRef TapeRef::find(std::string_view keyName) const {
+    if (CHECK_VALIDITY) assert(type() == OBJECT);
+    for (TapeRef member : *this) {
+        if (member.key() == keyName) return member;
+    }
+    return TapeRef{};
+}
+
+TapeRef TapeRef::at(std::string_view keyName) const {
+    TapeRef retRef = find(keyName);
+    if (!retRef.valid()) {
         std::cerr << "json object does not have key : " << keyName << std::endl;
         throw std::runtime_error("");
     }
-    Value retVal = obj.at(keyName);
+    return retRef;
+}
+
+void TapeRef::copyFloats(float* out) const {
+    if (isFloatArray()) {
+        std::span<const float> floats = toFloats();
+        std::copy(floats.begin(), floats.end(), out);
+        return;
+    }
+    for (TapeRef element : *this) *out++ = element.toNumber().toFloatDestructive();
+}
+
+TapeRef TapeRef::operator[](uint32_t elementIdx) const {
+    if (CHECK_VALIDITY) assert(elementIdx < size() && !isFloatArray());
+    iterator it = begin();
+    for (uint32_t j = 0; j < elementIdx; j++) ++it;
+    return *it;
+}
+
+const Value& JSONUtils::getVal(const Object& obj, std::string_view keyName, JSONDataType type, bool CHECK_VALIDITY) {
+    Object::const_iterator it = obj.find(keyName);
+    if (it == obj.end()) {
+        std::cerr << "json object does not have key : " << keyName << std::endl;
+        throw std::runtime_error("");
+    }
+    const Value& retVal = it->second;
     if (CHECK_VALIDITY && !(retVal.type == type)) {
         std::cerr << "json object value does not have type" << JSONDataTypeStrings.at(type) << std::endl;
         throw std::runtime_error("");
@@ -281,13 +738,12 @@ Value JSONUtils::getVal(const Object& obj, std::string keyName, JSONDataType typ
     return retVal;
 };
 
-std::string JSONUtils::getName(const Object& JSONObj, bool CHECK_VALIDITY) {
-    Value nameVal = JSONObj.at("name");
-    if (CHECK_VALIDITY) assert(nameVal.type == STRING);
+std::string_view JSONUtils::getName(const Object& JSONObj, bool CHECK_VALIDITY) {
+    const Value& nameVal = getVal(JSONObj, "name", STRING, CHECK_VALIDITY);
     return nameVal.toString();
 };
 
-void JSONUtils::getFloat3(Array arrVal, float* A, float* B, float* C) {
+void JSONUtils::getFloat3(const Array& arrVal, float* A, float* B, float* C) {
     assert(arrVal.size() == 3);
     assert(arrVal[0].type == NUMBER);
     *A = arrVal[0].toNumber().toFloatDestructive();
@@ -297,67 +753,51 @@ void JSONUtils::getFloat3(Array arrVal, float* A, float* B, float* C) {
     *C = arrVal[2].toNumber().toFloatDestructive();
 };
 
-std::vector<size_t> JSONUtils::getIndices(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY) {
+std::vector<size_t> JSONUtils::getIndices(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
     std::vector<size_t> retIndices;
-    Array indicesArr = getVal(JSONObj, attrName, ARRAY).toArray();
-    size_t indicesSize = indicesArr.size();
-    retIndices.reserve(indicesSize);
-    for (size_t i = 0; i < indicesSize; i++) {
-        Value curVal = indicesArr[i];
+    const Array& indicesArr = getVal(JSONObj, attrName, ARRAY, CHECK_VALIDITY).toArray();
+    retIndices.reserve(indicesArr.size());
+    for (const Value& curVal : indicesArr) {
         if (CHECK_VALIDITY) assert(curVal.type == NUMBER);
-        Number num = curVal.toNumber();
+        const Number& num = curVal.toNumber();
         if (CHECK_VALIDITY) assert(!num.negative && num.type == INT && std::holds_alternative<size_t>(num.val));
         retIndices.emplace_back(num.toSizeT());
     }
     return retIndices;
 };
 
-std::vector<std::string> JSONUtils::getIndicesNames(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY) {
-    std::vector<std::string> retIndicesNames;
-    Array indicesArr = getVal(JSONObj, attrName, ARRAY).toArray();
-    size_t indicesSize = indicesArr.size();
-    retIndicesNames.reserve(indicesSize);
-    for (size_t i = 0; i < indicesSize; i++) {
-        Value curVal = indicesArr[i];
+std::vector<std::string_view> JSONUtils::getIndicesNames(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
+    std::vector<std::string_view> retIndicesNames;
+    const Array& indicesArr = getVal(JSONObj, attrName, ARRAY, CHECK_VALIDITY).toArray();
+    retIndicesNames.reserve(indicesArr.size());
+    for (const Value& curVal : indicesArr) {
         if (CHECK_VALIDITY) assert(curVal.type == STRING);
-        std::string name = curVal.toString();
-        retIndicesNames.emplace_back(name);
+        retIndicesNames.emplace_back(curVal.toString());
     }
     return retIndicesNames;
 };
 
-std::vector<float> JSONUtils::getFloats(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY) {
+std::vector<float> JSONUtils::getFloats(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
     std::vector<float> retFloats;
-    Array floatsArr = getVal(JSONObj, attrName, ARRAY).toArray();
-    size_t floatsSize = floatsArr.size();
-    retFloats.reserve(floatsSize);
-    for (size_t i = 0; i < floatsSize; i++) {
-        Value curVal = floatsArr[i];
+    const Array& floatsArr = getVal(JSONObj, attrName, ARRAY, CHECK_VALIDITY).toArray();
+    retFloats.reserve(floatsArr.size());
+    for (const Value& curVal : floatsArr) {
         if (CHECK_VALIDITY) assert(curVal.type == NUMBER);
         retFloats.emplace_back(curVal.toNumber().toFloatDestructive());
     }
     return retFloats;
 };
 
-glm::vec3 JSONUtils::getVec3(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY) {
-    Value nameVal = JSONObj.at(attrName);
-    if (CHECK_VALIDITY) assert(nameVal.type == ARRAY);
-    Array arrVal = nameVal.toArray();
+glm::vec3 JSONUtils::getVec3(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
+    const Array& arrVal = getVal(JSONObj, attrName, ARRAY, CHECK_VALIDITY).toArray();
     if (CHECK_VALIDITY) assert(arrVal.size() == 3);
-    if (CHECK_VALIDITY) assert(arrVal[0].type == NUMBER);
-    float x = arrVal[0].toNumber().toFloatDestructive();
-    if (CHECK_VALIDITY) assert(arrVal[1].type == NUMBER);
-    float y = arrVal[1].toNumber().toFloatDestructive();
-    if (CHECK_VALIDITY) assert(arrVal[2].type == NUMBER);
-    float z = arrVal[2].toNumber().toFloatDestructive();
+    float x, y, z;
+    getFloat3(arrVal, &x, &y, &z);
     return glm::vec3(x, y, z);
 };
 
-glm::quat JSONUtils::getQuat(const Object& JSONObj, std::string attrName, bool CHECK_VALIDITY) {
-    if (CHECK_VALIDITY) assert(JSONObj.count(attrName) > 0);
-    Value nameVal = JSONObj.at(attrName);
-    if (CHECK_VALIDITY) assert(nameVal.type == ARRAY);
-    Array arrVal = nameVal.toArray();
+glm::quat JSONUtils::getQuat(const Object& JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
+    const Array& arrVal = getVal(JSONObj, attrName, ARRAY, CHECK_VALIDITY).toArray();
     if (CHECK_VALIDITY) assert(arrVal.size() == 4);
     if (CHECK_VALIDITY) assert(arrVal[0].type == NUMBER);
     float x = arrVal[0].toNumber().toFloatDestructive();
@@ -365,4 +805,90 @@ glm::quat JSONUtils::getQuat(const Object& JSONObj, std::string attrName, bool C
     float z = arrVal[2].toNumber().toFloatDestructive();
     float w = arrVal[3].toNumber().toFloatDestructive();
     return glm::quat(w, x, y, z); //TODO Change input order to reflect own implemenetation
-};
\ No newline at end of file
+};
+
+TapeRef JSONUtils::getVal(TapeRef obj, std::string_view keyName, JSONDataType type, bool CHECK_VALIDITY) {
+    TapeRef retVal = obj.find(keyName);
+    if (CHECK_VALIDITY && !retVal.valid()) {
+        std::cerr << "json object does not have key : " << keyName << std::endl;
+        throw std::runtime_error("");
+    }
+    if (CHECK_VALIDITY && !(retVal.type() == type)) {
+        std::cerr << "json object value does not have type" << JSONDataTypeStrings.at(type) << std::endl;
+        throw std::runtime_error("");
+    }
+
+    return retVal;
+};
+
+std::string_view JSONUtils::getName(TapeRef JSONObj, bool CHECK_VALIDITY) {
+    TapeRef nameVal = JSONObj.at("name");
+    if (CHECK_VALIDITY) assert(nameVal.type() == STRING);
+    return nameVal.toString();
+};
+
+void JSONUtils::getFloat3(TapeRef arrVal, float* A, float* B, float* C) {
+    assert(arrVal.type() == ARRAY && arrVal.size() == 3);
+    float floats[3];
+    arrVal.copyFloats(floats);
+    *A = floats[0];
+    *B = floats[1];
+    *C = floats[2];
+};
+
+std::vector<size_t> JSONUtils::getIndices(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
+    std::vector<size_t> retIndices;
+    TapeRef indicesArr = getVal(JSONObj, attrName, ARRAY);
+    if (indicesArr.size() == 0) return retIndices;
+    retIndices.reserve(indicesArr.size());
+    //indices from 2^24 on keep their Number tokens, smaller ones are exact in the float storage
+    if (!indicesArr.isFloatArray()) {
+        for (TapeRef curVal : indicesArr) {
+            if (CHECK_VALIDITY) assert(curVal.type() == NUMBER);
+            retIndices.emplace_back(curVal.toNumber().toSizeT());
+        }
+        return retIndices;
+    }
+    for (float curVal : indicesArr.toFloats()) {
+        if (CHECK_VALIDITY) assert(curVal >= 0.0f && curVal == static_cast<float>(static_cast<size_t>(curVal)));
+        retIndices.emplace_back(static_cast<size_t>(curVal));
+    }
+    return retIndices;
+};
+
+std::vector<std::string_view> JSONUtils::getIndicesNames(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
+    std::vector<std::string_view> retIndicesNames;
+    TapeRef indicesArr = getVal(JSONObj, attrName, ARRAY);
+    retIndicesNames.reserve(indicesArr.size());
+    for (TapeRef curVal : indicesArr) {
+        if (CHECK_VALIDITY) assert(curVal.type() == STRING);
+        retIndicesNames.emplace_back(curVal.toString());
+    }
+    return retIndicesNames;
+};
+
+std::vector<float> JSONUtils::getFloats(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
+    TapeRef floatsArr = getVal(JSONObj, attrName, ARRAY, CHECK_VALIDITY);
+    if (floatsArr.size() == 0) return {};
+    std::vector<float> floats(floatsArr.size());
+    floatsArr.copyFloats(floats.data());
+    return floats;
+};
+
+glm::vec3 JSONUtils::getVec3(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
+    TapeRef arrVal = JSONObj.at(attrName);
+    if (CHECK_VALIDITY) assert(arrVal.type() == ARRAY);
+    if (CHECK_VALIDITY) assert(arrVal.size() == 3);
+    float x, y, z;
+    getFloat3(arrVal, &x, &y, &z);
+    return glm::vec3(x, y, z);
+};
+
+glm::quat JSONUtils::getQuat(TapeRef JSONObj, std::string_view attrName, bool CHECK_VALIDITY) {
+    TapeRef arrVal = JSONObj.at(attrName);
+    if (CHECK_VALIDITY) assert(arrVal.type() == ARRAY);
+    if (CHECK_VALIDITY) assert(arrVal.size() == 4);
+    float quatVals[4];
+    arrVal.copyFloats(quatVals);
+    return glm::quat(quatVals[3], quatVals[0], quatVals[1], quatVals[2]); //TODO Change input order to reflect own implemenetation
+};
@@ -0,0 +1,155 @@
+#include "../headers/jsonStructural.hpp"
+#include <cassert>
+#include <cstring>
+#include <bit>
+#include <limits>
+
+#if !defined(JSON_FORCE_SCALAR) && defined(__AVX2__)
+#define JSON_STRUCTURAL_AVX2
+#include <immintrin.h>
+#elif !defined(JSON_FORCE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define JSON_STRUCTURAL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 64;
+
+    //one bit per byte of a 64 byte block
+    struct BlockMasks {
+        uint64_t quote = 0;
+        uint64_t backslash = 0;
+        uint64_t op = 0;
+        uint64_t whitespace = 0;
+    };
+
+#if defined(JSON_STRUCTURAL_AVX2)
+    inline uint64_t movemask32(__m256i cmp) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(cmp)));
+    }
+
+    BlockMasks classifyBlock(const char* block) {
+        BlockMasks masks{};
+        for (size_t half = 0; half < 2; half++) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + half * 32));
+            const __m256i op = _mm256_or_si256(
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}'))),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('[')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(']')))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+            const __m256i whitespace = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))));
+            const size_t shift = half * 32;
+            masks.quote |= movemask32(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << shift;
+            masks.backslash |= movemask32(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << shift;
+            masks.op |= movemask32(op) << shift;
+            masks.whitespace |= movemask32(whitespace) << shift;
+        }
+        return masks;
+    }
+#elif defined(JSON_STRUCTURAL_SSE2)
+    inline uint64_t movemask16(__m128i cmp) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(cmp)));
+    }
+
+    BlockMasks classifyBlock(const char* block) {
+        BlockMasks masks{};
+        for (size_t quarter = 0; quarter < 4; quarter++) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + quarter * 16));
+            const __m128i op = _mm_or_si128(
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('{')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}'))),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('[')), _mm_cmpeq_epi8(v, _mm_set1_epi8(']')))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+            const __m128i whitespace = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+            const size_t shift = quarter * 16;
+            masks.quote |= movemask16(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << shift;
+            masks.backslash |= movemask16(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << shift;
+            masks.op |= movemask16(op) << shift;
+            masks.whitespace |= movemask16(whitespace) << shift;
+        }
+        return masks;
+    }
+#else
+    BlockMasks classifyBlock(const char* block) {
+        BlockMasks masks{};
+        for (size_t j = 0; j < BLOCK_SIZE; j++) {
+            const uint8_t charClass = JSON_CHAR_CLASSES[static_cast<unsigned char>(block[j])];
+            const uint64_t bit = uint64_t(1) << j;
+            if (charClass & JSON_QUOTE_CHAR) masks.quote |= bit;
+            if (charClass & JSON_BACKSLASH_CHAR) masks.backslash |= bit;
+            if (charClass & JSON_OP_CHAR) masks.op |= bit;
+            if (charClass & JSON_WHITESPACE_CHAR) masks.whitespace |= bit;
+        }
+        return masks;
+    }
+#endif
+
+    //bit i of result is the xor of bits 0..i of x, turns quote positions into an "inside string" mask
+    inline uint64_t prefixXor(uint64_t x) {
+        x ^= x << 1;
+        x ^= x << 2;
+        x ^= x << 4;
+        x ^= x << 8;
+        x ^= x << 16;
+        x ^= x << 32;
+        return x;
+    }
+
+    //marks characters preceded by an odd-length run of backslashes, prevEscaped carries the run between blocks
+    inline uint64_t findEscaped(uint64_t backslash, uint64_t& prevEscaped) {
+        constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+        backslash &= ~prevEscaped;
+        const uint64_t followsEscape = (backslash << 1) | prevEscaped;
+        const uint64_t oddSequenceStarts = backslash & ~EVEN_BITS & ~followsEscape;
+        const uint64_t sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+        prevEscaped = (sequencesStartingOnEvenBits < oddSequenceStarts) ? 1 : 0; //carry out of the add
+        const uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+        return (EVEN_BITS ^ invertMask) & followsEscape;
+    }
+}
+
+void findStructurals(const char* data, size_t size, std::vector<uint32_t>& structurals) {
+    assert(size < std::numeric_limits<uint32_t>::max());
+    structurals.clear();
+    //s72 files are roughly 1 structural per 6 bytes
+    structurals.reserve(size / 6 + 2);
+
+    uint64_t prevEscaped = 0;
+    uint64_t prevInString = 0;
+    uint64_t prevScalar = 0;
+    char padded[BLOCK_SIZE];
+
+    for (size_t blockStart = 0; blockStart < size; blockStart += BLOCK_SIZE) {
+        const char* block = data + blockStart;
+        //last block is padded with whitespace so the SIMD loads never read past the buffer
+        if (blockStart + BLOCK_SIZE > size) {
+            std::memset(padded, ' ', BLOCK_SIZE);
+            std::memcpy(padded, block, size - blockStart);
+            block = padded;
+        }
+
+        const BlockMasks masks = classifyBlock(block);
+        const uint64_t escaped = findEscaped(masks.backslash, prevEscaped);
+        const uint64_t quote = masks.quote & ~escaped;
+        //includes the opening quote, excludes the closing one
+        const uint64_t inString = prefixXor(quote) ^ prevInString;
+        prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+        //string contents and closing quote
+        const uint64_t stringTail = inString ^ quote;
+
+        //anything that is not an op or whitespace is part of a scalar (number, literal or string)
+        const uint64_t scalar = ~(masks.op | masks.whitespace);
+        const uint64_t followsScalar = (scalar << 1) | prevScalar;
+        prevScalar = scalar >> 63;
+
+        uint64_t structural = (masks.op | (scalar & ~followsScalar)) & ~stringTail;
+        while (structural != 0) {
+            structurals.push_back(static_cast<uint32_t>(blockStart + std::countr_zero(structural)));
+            structural &= structural - 1;
+        }
+    }
+
+    structurals.push_back(static_cast<uint32_t>(size));
+}
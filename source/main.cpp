@@ -35,10 +35,22 @@ static const std::string helpMessage = " To run application, arguments must form
     1 (DEFAULT), 2, 4, 8, 16, 32, 64 \n \
 [] --headless {events}, path to UTF-8-encoded text file to perform application in headless mode.\n \
 		Must supply drawing_size in this case \n \
-[] --stripify : stripify mesh of scene into triangle strips with tunneling algirthm in stripify.cpp \n \
-[] --cluster : cluser mesh into mesh lets of size cluster_size, with default of 64 \n \
-           if culling is activated, culling isbased off meshlet bounding boxes and not mesh boinding boxes \n \
-[] --cluster-size {s} : number of vertices in each triangle strip cluster size \n";
+[] --stripify : draw triangle list meshes as triangle strips joined by restart indices, see stripify.hpp \n \
+[] --cluster : split meshes into meshlets of at most cluster-size vertices, meshlets facing away from the camera are culled \n \
+           and if culling is activated, culling is also done against meshlet bounding boxes and not just mesh bounding boxes \n \
+[] --cluster-size {s} : most vertices in each meshlet, 64 (DEFAULT), meshlets hold up to 2s - 4 triangles \n \
+[] --lod-levels {l} : simplify each triangle list mesh into l - 1 LODs of about half the triangles of the one before, 1 (DEFAULT) to 4, \n \
+           each instance draws the LOD its projected size on screen calls for \n \
+[] --load-threads {t} : threads used to parse the scene file and load its meshes, 0 (DEFAULT) uses every hardware thread, 1 loads serially \n \
+[] --no-scene-cache : always load the scene from source, without reading or writing the {scene}.s72b binary cache \n \
+[] --stream-meshes : show the scene as soon as its graph is loaded, meshes load in the background and appear as they finish \n \
+[] --hot-reload : watch the scene and its mesh files, edits to transforms, cameras, drivers and mesh data are applied without restarting. the scene is always loaded from source and meshes are not streamed \n \
+[] --optimize-vertex-cache : reorder the triangles of each mesh for the post-transform vertex cache (Tipsify), then its vertices in first use order, and print the ACMR / ATVR before and after \n \
+[] --vertex-layout {layout} : how vertices are stored on the gpu, one of \n \
+       full (DEFAULT), 52 bytes per vertex \n \
+       compact, 24 bytes per vertex, quantized positions, octahedral normals and tangents, half float texCoords \n \
+[] --split-positions : store the positions of every vertex in their own tightly packed stream ahead of the rest of the layout, \n \
+           so depth only passes fetch just the positions \n";
 
 
 int main(int argc, char* argv[]) {
@@ -90,6 +102,9 @@ int main(int argc, char* argv[]) {
                     if (!Mode::current) break;
                 }
 
+                //meshes streamed in during update
+                app.uploadDirtyVertexIndexRanges();
+
                 std::pair<VkCommandBuffer, uint32_t> beginInfo = app.beginFrame();
                 //if beginning return null,(ie if window resized and swachain needed to be resize), 
                 //beginInfo is invalid
@@ -1,6 +1,11 @@
 #include "mesh.hpp"
+#include "utils.hpp"
+#include "vertexWeld.hpp"
+#include "meshlet.hpp"
 #include <fstream>
+#include <filesystem>
 #include <algorithm>
+#include <cstring>
 
 
 void Bounds::enclose(float x, float y, float z) {
@@ -35,62 +40,130 @@ void Bounds::fixZeroVolume(){
 }
 
 
-//will populate vertex and index buffers manually
-void Mesh::toIndexed(const std::vector<Vertex>& srcBuffer) {
-	indices.reserve(indices.size() + srcBuffer.size());
-	std::unordered_map<Vertex, Index> duplicateCheck{};
-	for (const Vertex& vertex : srcBuffer) {
-		if (!duplicateCheck.count(vertex)) {
-			duplicateCheck.insert({ vertex, vertices.size() });
-			indices.emplace_back(vertices.size());
-			vertices.emplace_back(vertex);
-		}
-		else {
-			indices.emplace_back(duplicateCheck[vertex]);
-		}
+std::string Mesh::findFile(const std::string& filename) {
+	//TODO store meshes in folder other than scenes ?
+	for (std::string tryPath : std::vector<std::string>{ "scenes\\" + filename, filename, "meshes\\" + filename, "scenes\\meshes\\" + filename }) {
+		if (std::ifstream(tryPath, std::ios::binary).good()) return tryPath;
 	}
+	return "";
 }
 
-void Mesh::loadMeshData(const std::string filename, const Object& JSONObj, const ModeConstantParameters& parameters) {
-	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
-	//TODO store meshes in folder other than scenes ?
-	std::ifstream file;
-	for (std::string tryPath : std::vector<std::string>{ "scenes\\" + filename, filename, "meshes\\" + filename, "scenes\\meshes\\" + filename }) {
-		file = std::ifstream(tryPath, std::ios::ate | std::ios::binary);
-		if (file.good()) break;
+uint32_t Mesh::toIndexed(Vertex* meshVertices, uint32_t count, Index* indicesOut, size_t numThreads) {
+	return weldVertices(meshVertices, count, indicesOut, numThreads);
+}
+
+void Mesh::appendMeshData(const MeshStaging& staging) {
+	indexOffset = indices.size();
+	vertexOffset = vertices.size();
+	indices.insert(indices.end(), staging.indices.begin(), staging.indices.end());
+	vertices.insert(vertices.end(), staging.vertices.begin(), staging.vertices.end());
+}
+
+void Mesh::shareMeshData(const Mesh& other) {
+	indexOffset = other.indexOffset;
+	numIndices = other.numIndices;
+	vertexOffset = other.vertexOffset;
+	lods = other.lods;
+	numLods = other.numLods;
+	bounds = other.bounds;
+	boundingSphere = other.boundingSphere;
+	orientedBounds = other.orientedBounds;
+	meshletOffset = other.meshletOffset;
+	numMeshlets = other.numMeshlets;
+}
+
+uint64_t MeshStaging::hash() const {
+	return hashXXH64(indices.data(), indices.size() * sizeof(Index), hashXXH64(vertices.data(), vertices.size() * sizeof(Vertex)));
+}
+
+bool MeshStaging::sameBytes(const MeshStaging& other) const {
+	return vertices.size() == other.vertices.size() && indices.size() == other.indices.size() &&
+		memcmp(vertices.data(), other.vertices.data(), vertices.size() * sizeof(Vertex)) == 0 &&
+		memcmp(indices.data(), other.indices.data(), indices.size() * sizeof(Index)) == 0;
+}
+
+std::string Mesh::geometryKey(const S72Mesh& s72Mesh) {
+	//'\0' can't appear in a name, so fields can't run into each other
+	std::string key;
+	auto append = [&key](std::string_view field) {
+		key.append(field);
+		key.push_back('\0');
+	};
+	append(s72Mesh.topology);
+	append(std::to_string(s72Mesh.count));
+	for (const S72Attribute& attribute : s72Mesh.attributes) {
+		append(attribute.name);
+		append(attribute.src);
+		append(std::to_string(attribute.offset));
+		append(std::to_string(attribute.stride));
+		append(attribute.format);
 	}
-	if (!file.good() || !file.is_open())  throw std::runtime_error("Failed to find or open file!");
-	file.seekg(0);
+	append(s72Mesh.indices.src);
+	append(std::to_string(s72Mesh.indices.offset));
+	append(s72Mesh.indices.format);
+	return key;
+}
+
+MeshSize Mesh::plannedSize(const S72Mesh& s72Mesh, const ModeConstantParameters& parameters) {
+	MeshSize size{ s72Mesh.count, s72Mesh.count };
+	if (S72_HAS(s72Mesh, "indices")) {
+		const S72Indices& indicesAttr = s72Mesh.indices;
+		size_t indexFormatIdx = S72::INDEX_FORMATS.find(indicesAttr.format);
+		if (indexFormatIdx == S72::INDEX_FORMATS.keys.size()) throw std::runtime_error("Index format unrecognized!");
+		//indices run from offset to the end of the file, so the file size is enough
+		std::error_code error;
+		uint64_t fileSize = std::filesystem::file_size(findFile(std::string(indicesAttr.src)), error);
+		if (error) throw std::runtime_error("Failed to find or open file!");
+		size.indices = fileSize > indicesAttr.offset ? static_cast<uint32_t>((fileSize - indicesAttr.offset) / S72::INDEX_FORMAT_SIZES[indexFormatIdx]) : 0;
+	}
+	const bool triangleList = s72Mesh.topology == "TRIANGLE_LIST";
+	const uint32_t listIndices = size.indices;
+	if (parameters.STRIPIFY && triangleList) size.indices = std::max(size.indices, maxStripIndices(size.indices));
+	//LODs together hold no more triangles than the mesh itself, see loadMeshData
+	if (lodLevels(parameters) > 1 && triangleList) size.indices += parameters.STRIPIFY ? maxStripIndices(listIndices) : listIndices / 3 * 3;
+	return size;
+}
+
+void Mesh::loadMeshData(const std::string& filename, const S72Mesh& s72Mesh, const ModeConstantParameters& parameters, MeshStaging& staging) {
+	MeshSize size = plannedSize(s72Mesh, parameters);
+	staging.vertices.resize(size.vertices);
+	staging.indices.resize(size.indices);
+	staging.meshlets.clear();
+	uint32_t numVertices = loadMeshData(filename, s72Mesh, parameters, staging.vertices.data(), staging.indices.data(), size, &staging.meshlets);
+	staging.vertices.resize(numVertices);
+	staging.indices.resize(totalIndices());
+}
+
+uint32_t Mesh::loadMeshData(const std::string& filename, const S72Mesh& s72Mesh, const ModeConstantParameters& parameters, Vertex* vertexOut, Index* indexOut, MeshSize size,
+	std::vector<Meshlet>* meshletsOut, MeshLoadReport* report) {
+	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
+	MappedFile file;
+	if (!file.open(findFile(filename)))  throw std::runtime_error("Failed to find or open file!");
 
 
 	struct VertexAttribute {
-		std::string name;
-		std::string format;
+		std::string_view name;
+		std::string_view format;
 		uint32_t formatSize;
 		uint32_t stride;
 		uint32_t offset;
 	};
 	std::vector<VertexAttribute> vertexAttributes;
-	Object attributesObj = JSONUtils::getVal(JSONObj, "attributes", OBJECT).toObject();
-	vertexAttributes.reserve(attributesObj.size());
+	vertexAttributes.reserve(s72Mesh.attributes.size());
 	//TODO actually deal with different format types, mayeb by outputing a VertexBingindAttributes array ?
-	for (const auto& pair : attributesObj) {
+	for (const S72Attribute& attribInfo : s72Mesh.attributes) {
 		VertexAttribute curAttrib{};
-		curAttrib.name = pair.first;
-		Object attribInfo = JSONUtils::getVal(attributesObj, curAttrib.name, OBJECT).toObject();
+		curAttrib.name = attribInfo.name;
 		if (CHECK_VALIDITY) {
-			curAttrib.format = JSONUtils::getVal(attribInfo, "format", STRING).toString();
-			if (curAttrib.format == "R32G32B32_SFLOAT") curAttrib.formatSize = 12;
-			else if (curAttrib.format == "R32G32B32A32_SFLOAT") curAttrib.formatSize = 16;
-			else if (curAttrib.format == "R32G32_SFLOAT") curAttrib.formatSize = 8;
-			else if (curAttrib.format == "R32_SFLOAT") curAttrib.formatSize = 4;
-			else if (curAttrib.format == "R8G8B8A8_UNORM") curAttrib.formatSize = 4;
-			else {
-				throw std::runtime_error("\n\nUnseen attribute format : " + curAttrib.format + "!");
+			curAttrib.format = attribInfo.format;
+			size_t formatIdx = S72::ATTRIBUTE_FORMATS.find(curAttrib.format);
+			if (formatIdx == S72::ATTRIBUTE_FORMATS.keys.size()) {
+				throw std::runtime_error("\n\nUnseen attribute format : " + std::string(curAttrib.format) + "!");
 			}
+			curAttrib.formatSize = S72::ATTRIBUTE_FORMAT_SIZES[formatIdx];
 		}
-		curAttrib.stride = JSONUtils::getVal(attribInfo, "stride", NUMBER).toNumber().toSizeT();
-		curAttrib.offset = JSONUtils::getVal(attribInfo, "offset", NUMBER).toNumber().toSizeT();
+		curAttrib.stride = attribInfo.stride;
+		curAttrib.offset = attribInfo.offset;
 
 		vertexAttributes.emplace_back(curAttrib);
 	}
@@ -110,139 +183,228 @@ void Mesh::loadMeshData(const std::string filename, const Object& JSONObj, const
 		if ((vertexAttributes.size() == 0) || (vertexAttributes[0].stride != vertexSize)) dataPacked = false;
 		//TODO what to do if data is not packed ?
 	}
-	uint32_t count = JSONUtils::getVal(JSONObj, "count", NUMBER).toNumber().toSizeT();
+	uint32_t count = s72Mesh.count;
 	uint32_t stride = vertexAttributes[0].stride;
 
-	size_t fileSize = count * stride;
-	std::vector<Vertex> buffer(count);
+	size_t fileSize = static_cast<size_t>(count) * stride;
+	if (count > size.vertices) throw std::runtime_error("Mesh has more vertices than were planned for!");
+	if (file.size() < fileSize) throw std::runtime_error("Mesh file is smaller than its attributes say!");
+	const char* fileData = file.data();
 
 	if (dataPacked && vertexAttributes.size() == 5 && vertexAttributes[0].name == "POSITION" && vertexAttributes[1].name == "NORMAL" &&
 		vertexAttributes[2].name == "TANGENT" && vertexAttributes[3].name == "TEXCOORD" && vertexAttributes[4].name == "COLOR") {
 #if defined(SIMPLE_VERTEX) && SIMPLE_VERTEX
 		int positionOffset = -1, colorOffset = -1;
 		for (VertexAttribute attr : vertexAttributes) {
-			if (attr.name == "POSITION") positionOffset = attr.offset;
-			else if (attr.name == "COLOR") colorOffset = attr.offset;
+			switch (S72::ATTRIBUTE_NAMES.find(attr.name)) {
+			case S72::POSITION: positionOffset = attr.offset; break;
+			case S72::COLOR: colorOffset = attr.offset; break;
+			default: break;
+			}
 		}
-		std::vector<char>charBuffer(count * stride);
-		file.read(charBuffer.data(), fileSize);
 		for (uint32_t i = 0; i < count; i++) {
-			//will just trust that alignment issues won't mess things up...
-			//if it is, will need to use .seekg manually and fill single position/color buffers
-			if (positionOffset != -1) buffer[i].position = *(reinterpret_cast<glm::vec3*>(charBuffer.data() + i * stride + positionOffset));
-
-			if (colorOffset != -1) buffer[i].color = *(reinterpret_cast<uint32_t*>(charBuffer.data() + i * stride + colorOffset));
-
+			vertexOut[i] = Vertex{};
+			if (positionOffset != -1) std::memcpy(&vertexOut[i].position, fileData + i * stride + positionOffset, sizeof(glm::vec3));
+			if (colorOffset != -1) std::memcpy(&vertexOut[i].color, fileData + i * stride + colorOffset, sizeof(uint32_t));
 		}
-		charBuffer.clear();
 #else
-		file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
+		std::memcpy(vertexOut, fileData, fileSize);
 #endif
 	}
 #if defined(SIMPLE_VERTEX) && SIMPLE_VERTEX
-	else if (dataPacked && vertexAttributes.size() == 2 && vertexAttributes[0].name == "POSITION" && vertexAttributes[1].name == COLOR) {
-		file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
+	else if (dataPacked && vertexAttributes.size() == 2 && vertexAttributes[0].name == "POSITION" && vertexAttributes[1].name == "COLOR") {
+		std::memcpy(vertexOut, fileData, fileSize);
 	}
 #endif
 	else {
 		int positionOffset = -1, normalOffset = -1, tangentOffset = -1, texCoordOffset = -1, colorOffset = -1;
 		for (VertexAttribute attr : vertexAttributes) {
-			if (attr.name == "POSITION") positionOffset = attr.offset;
-			else if (attr.name == "COLOR") colorOffset = attr.offset;
+			switch (S72::ATTRIBUTE_NAMES.find(attr.name)) {
+			case S72::POSITION: positionOffset = attr.offset; break;
+			case S72::COLOR: colorOffset = attr.offset; break;
 #if defined(SIMPLE_VERTEX) && SIMPLE_VERTEX
 #else
-			else if (attr.name == "NORMAL") normalOffset = attr.offset;
-			else if (attr.name == "TANGENT") tangentOffset = attr.offset;
-			else if (attr.name == "TEXCOORD") texCoordOffset = attr.offset;
+			case S72::NORMAL: normalOffset = attr.offset; break;
+			case S72::TANGENT: tangentOffset = attr.offset; break;
+			case S72::TEXCOORD: texCoordOffset = attr.offset; break;
 #endif
+			default: break;
+			}
 		}
-		uint32_t stride = vertexAttributes[0].stride;
-		std::vector<char>charBuffer(count * stride);
-		file.read(charBuffer.data(), fileSize);
+		//attributes are copied out of the mapped file one by one, memcpy since they may not be aligned
 		for (uint32_t i = 0; i < count; i++) {
-			//will just trust that alignment issues won't mess things up...
-			//if it is, will need to use .seekg manually and fill single position/color buffers
-			if (positionOffset != -1) buffer[i].position = *(reinterpret_cast<glm::vec3*>(charBuffer.data() + i * stride + positionOffset));
-			if (colorOffset != -1) buffer[i].color = *(reinterpret_cast<uint32_t*>(charBuffer.data() + i * stride + colorOffset));
+			Vertex& vertex = vertexOut[i];
+			vertex = Vertex{};
+			const char* src = fileData + i * stride;
+			if (positionOffset != -1) std::memcpy(&vertex.position, src + positionOffset, sizeof(vertex.position));
+			if (colorOffset != -1) std::memcpy(&vertex.color, src + colorOffset, sizeof(vertex.color));
 			
 #if defined(SIMPLE_VERTEX) && SIMPLE_VERTEX
 #else
-			if (normalOffset != -1) buffer[i].normal = *(reinterpret_cast<glm::vec3*>(charBuffer.data() + i * stride + normalOffset));
-			if (tangentOffset != -1) buffer[i].tangent = *(reinterpret_cast<glm::vec4*>(charBuffer.data() + i * stride + tangentOffset));
-			if (texCoordOffset != -1) buffer[i].texCoord = *(reinterpret_cast<glm::vec4*>(charBuffer.data() + i * stride + texCoordOffset));
+			if (normalOffset != -1) std::memcpy(&vertex.normal, src + normalOffset, sizeof(vertex.normal));
+			if (tangentOffset != -1) std::memcpy(&vertex.tangent, src + tangentOffset, sizeof(vertex.tangent));
+			if (texCoordOffset != -1) std::memcpy(&vertex.texCoord, src + texCoordOffset, sizeof(vertex.texCoord));
 
 #endif
 		}
 	}
 
-	indexOffset = indices.size();
-	uint32_t uniqueVerticesStart = vertices.size();
-	//now stream indices if available
-	if (JSONObj.count("indicies")) {
-		Object indicesAttr = JSONUtils::getVal(JSONObj, "indices", OBJECT).toObject();
+	//now read indices if available
+	uint32_t numVertices = count;
+	if (S72_HAS(s72Mesh, "indices")) {
+		const S72Indices& indicesAttr = s72Mesh.indices;
 
-		std::string indicesFilename = JSONUtils::getVal(indicesAttr, "src", STRING).toString();
-		uint32_t offset = JSONUtils::getVal(indicesAttr, "offset", NUMBER).toNumber().toSizeT();
+		std::string indicesFilename = std::string(indicesAttr.src);
+		uint32_t offset = indicesAttr.offset;
 
 		if (indicesFilename != filename) {
 			file.close();
-			for (std::string tryPath : std::vector<std::string>{ "scenes\\" + indicesFilename, indicesFilename, "meshes\\" + indicesFilename, "scenes\\meshes\\" + indicesFilename }) {
-				file = std::ifstream(tryPath, std::ios::ate | std::ios::binary);
-				if (file.good()) break;
-			}
-			if (!file.good() || !file.is_open())  throw std::runtime_error("Failed to find or open file!");
+			if (!file.open(findFile(indicesFilename)))  throw std::runtime_error("Failed to find or open file!");
 		}
+		if (file.size() < offset) throw std::runtime_error("Mesh index offset is past the end of its file!");
 
-		size_t indexCharBufferSize = static_cast<size_t>(file.tellg()) - offset;
-		file.seekg(offset); 
-		std::string indexFormat = JSONUtils::getVal(JSONObj, "format", STRING).toString();
-		uint32_t indexSize;
-		if (indexFormat == "UINT16") indexSize = 2;
-		else if (indexFormat == "UINT32") indexSize = 4;
-		else if (indexFormat == "UINT8") indexSize = 1;
-		else throw std::runtime_error("Index format unrecognized!");
+		size_t indexCharBufferSize = file.size() - offset;
+		size_t indexFormatIdx = S72::INDEX_FORMATS.find(indicesAttr.format);
+		if (indexFormatIdx == S72::INDEX_FORMATS.keys.size()) throw std::runtime_error("Index format unrecognized!");
+		uint32_t indexSize = S72::INDEX_FORMAT_SIZES[indexFormatIdx];
 		numIndices = indexCharBufferSize / indexSize;
+		if (numIndices > size.indices) throw std::runtime_error("Mesh has more indices than were planned for!");
 
 		//TODO allow for specificiation of which index buffer we're reading into?
-		uint32_t localIndexBufferOffset = indices.size();
-		uint32_t numPrevVertices = vertices.size();
+		const char* indexData = file.data() + offset;
 		if (indexSize == sizeof(Index)) {
-			indices.resize(localIndexBufferOffset + numIndices);
-			file.read(reinterpret_cast<char*>(indices.data() + localIndexBufferOffset), indexCharBufferSize);
-			//need to account for vertex buffer might already have prev data so indices will point to wrong vertices
-			for (uint32_t i = localIndexBufferOffset; i < indices.size(); i++) indices[i] += numPrevVertices;
+			std::memcpy(indexOut, indexData, static_cast<size_t>(numIndices) * indexSize);
 		}
 		else {
-			indices.reserve(localIndexBufferOffset + numIndices);
-			if (indexSize == 1) {
-				std::vector<uint8_t> cachedIndices(numIndices);
-				file.read(reinterpret_cast<char*>(cachedIndices.data()), indexCharBufferSize);
-				for (uint8_t newIdx : cachedIndices) { indices.emplace_back(static_cast<Index>(newIdx) + static_cast<Index>(numPrevVertices)); }
-			}
-			else if (indexSize == 2) {
-				std::vector<uint16_t> cachedIndices(numIndices);
-				file.read(reinterpret_cast<char*>(cachedIndices.data()), indexCharBufferSize);
-				for (uint8_t newIdx : cachedIndices) { indices.emplace_back(static_cast<Index>(newIdx) + static_cast<Index>(numPrevVertices)); }
-			}
-			else if (indexSize == 4) {
-				std::vector<uint32_t> cachedIndices(numIndices);
-				file.read(reinterpret_cast<char*>(cachedIndices.data()), indexCharBufferSize);
-				for (uint8_t newIdx : cachedIndices) { indices.emplace_back(static_cast<Index>(newIdx) + static_cast<Index>(numPrevVertices)); }
+			for (uint32_t i = 0; i < numIndices; i++) {
+				if (indexSize == 1) indexOut[i] = static_cast<Index>(static_cast<uint8_t>(indexData[i]));
+				else if (indexSize == 2) {
+					uint16_t newIdx;
+					std::memcpy(&newIdx, indexData + i * 2, sizeof(newIdx));
+					indexOut[i] = static_cast<Index>(newIdx);
+				}
+				else if (indexSize == 4) {
+					uint32_t newIdx;
+					std::memcpy(&newIdx, indexData + i * 4, sizeof(newIdx));
+					indexOut[i] = static_cast<Index>(newIdx);
+				}
 			}
 		}
-		file.close();
-		vertices.insert(vertices.end(), buffer.begin(), buffer.end());
 	}
 	else {
-		file.close();
-		numIndices = buffer.size();
-		toIndexed(buffer);
+		if (count > size.indices) throw std::runtime_error("Mesh has more indices than were planned for!");
+		numIndices = count;
+		//large meshes are welded on several threads, see weldVertices
+		numVertices = toIndexed(vertexOut, count, indexOut, resolveThreadCount(parameters.LOAD_THREADS));
+	}
+	file.close();
+	//indices are local to the mesh, so only a single mesh's vertices have to fit in Index, not the whole scene's
+	//toIndexed stops with one vertex too many before it writes an index that doesn't fit
+	if (numVertices > PRIMITIVE_RESTART_IDX) throw std::runtime_error("Mesh has more vertices than Index can address, build with INDEX_32BIT!");
+
+	//only triangle lists whose indices are all in range are reordered, anything else is left as exported
+	const bool triangleList = s72Mesh.topology == "TRIANGLE_LIST" && numIndices % 3 == 0;
+	const bool indicesInRange = std::all_of(indexOut, indexOut + numIndices, [numVertices](Index idx) { return idx < numVertices; });
+	if (parameters.OPTIMIZE_VERTEX_CACHE && triangleList && indicesInRange) {
+		VertexCacheReport cacheReport{};
+		cacheReport.before = analyzeVertexCache(indexOut, numIndices, numVertices);
+		optimizeVertexCache(indexOut, numIndices, numVertices);
+		numVertices = optimizeVertexFetch(vertexOut, numVertices, indexOut, numIndices);
+		cacheReport.after = analyzeVertexCache(indexOut, numIndices, numVertices);
+		if (report) report->vertexCache += cacheReport;
 	}
-	uint32_t uniqueVerticesEnd = vertices.size();
+
 	//fill in bounds structure
-	for (uint32_t i = uniqueVerticesStart; i < uniqueVerticesEnd; i++) {
-		bounds.enclose(vertices[i].position);
+	for (uint32_t i = 0; i < numVertices; i++) {
+		bounds.enclose(vertexOut[i].position);
 	}
 	bounds.fixZeroVolume();
+	boundingSphere = fitBoundingSphere(vertexOut, numVertices);
+	orientedBounds = fitOrientedBounds(vertexOut, numVertices, Bounds::MIN_AXIS_SIZE / 2.0f);
 
-}
\ No newline at end of file
+	//every LOD is simplified from the full mesh, aiming for half the triangles of the one before with twice the error.
+	//they are kept aside until LOD 0's indices are final, since stripify can lengthen them
+	std::vector<std::vector<Index>> lodIndices;
+	numLods = 0;
+	if (lodLevels(parameters) > 1 && triangleList && indicesInRange) {
+		const float diagonal = glm::length(glm::vec3(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY, bounds.maxZ - bounds.minZ));
+		uint32_t budget = numIndices; //see plannedSize
+		uint32_t previous = numIndices;
+		std::vector<Index> lod(numIndices);
+		for (uint32_t level = 1; level < lodLevels(parameters); level++) {
+			float error = 0.0f;
+			uint32_t count = simplifyMesh(vertexOut, numVertices, indexOut, numIndices, previous / 6 * 3, diagonal * LOD_ERROR * static_cast<float>(1U << (level - 1)),
+				lod.data(), &error);
+			//a LOD that barely simplified isn't worth its indices, and the ones after it would do no better
+			if (count == 0 || count > previous - previous / 4 || count > budget) break;
+			if (parameters.OPTIMIZE_VERTEX_CACHE) optimizeVertexCache(lod.data(), count, numVertices);
+			lodIndices.emplace_back(lod.begin(), lod.begin() + count);
+			lods[level - 1].error = error;
+			budget -= count;
+			previous = count;
+		}
+		if (report) {
+			report->lods.baseIndices += numIndices;
+			report->lods.lods += lodIndices.size();
+			for (const std::vector<Index>& levelIndices : lodIndices) report->lods.lodIndices += levelIndices.size();
+		}
+	}
+
+	//meshlets keep the vertex cache order of the triangles within each meshlet
+	const size_t firstMeshlet = meshletsOut ? meshletsOut->size() : 0;
+	if (parameters.CLUSTER && meshletsOut && triangleList && indicesInRange) {
+		buildMeshlets(vertexOut, numVertices, indexOut, numIndices, static_cast<uint32_t>(std::max(parameters.CLUSTER_SIZE, 0)), *meshletsOut);
+	}
+	const size_t endMeshlet = meshletsOut ? meshletsOut->size() : 0;
+	numMeshlets = static_cast<uint32_t>(endMeshlet - firstMeshlet);
+
+	//after the vertex cache pass, so strips are grown along its triangle order. the pipeline draws every mesh as
+	//strips with STRIPIFY, see App::createGraphicsPipeline
+	if (parameters.STRIPIFY && triangleList) {
+		//a vertex numbered PRIMITIVE_RESTART_IDX would read as a restart
+		if (!indicesInRange || std::find(indexOut, indexOut + numIndices, PRIMITIVE_RESTART_IDX) != indexOut + numIndices) {
+			throw std::runtime_error("Mesh index out of range, can't stripify!");
+		}
+		std::vector<Index> strips;
+		StripifyStats stripStats{};
+		if (endMeshlet > firstMeshlet) {
+			//each meshlet is stripified on its own and ends in a restart, so a run of meshlets is still a valid draw
+			std::vector<Index> meshletStrips;
+			for (size_t meshletIdx = firstMeshlet; meshletIdx < endMeshlet; meshletIdx++) {
+				Meshlet& meshlet = (*meshletsOut)[meshletIdx];
+				StripifyStats meshletStats = stripify(indexOut + meshlet.firstIndex, meshlet.numIndices, meshletStrips);
+				meshletStrips.emplace_back(PRIMITIVE_RESTART_IDX);
+				meshletStats.stripIndices++;
+				meshlet.firstIndex = static_cast<uint32_t>(strips.size());
+				meshlet.numIndices = static_cast<uint32_t>(meshletStrips.size());
+				strips.insert(strips.end(), meshletStrips.begin(), meshletStrips.end());
+				stripStats += meshletStats;
+			}
+		}
+		else stripStats = stripify(indexOut, numIndices, strips);
+		if (strips.size() > size.indices) throw std::runtime_error("Mesh has more strip indices than were planned for!");
+		std::copy(strips.begin(), strips.end(), indexOut);
+		numIndices = static_cast<uint32_t>(strips.size());
+		if (report) report->strips += stripStats;
+	}
+
+	//LODs go after LOD 0, each stripified on its own
+	uint32_t nextIndex = numIndices;
+	for (size_t level = 0; level < lodIndices.size(); level++) {
+		std::vector<Index>& levelIndices = lodIndices[level];
+		if (parameters.STRIPIFY) {
+			std::vector<Index> strips;
+			StripifyStats stripStats = stripify(levelIndices.data(), static_cast<uint32_t>(levelIndices.size()), strips);
+			levelIndices.swap(strips);
+			if (report) report->strips += stripStats;
+		}
+		if (nextIndex + levelIndices.size() > size.indices) throw std::runtime_error("Mesh LODs have more indices than were planned for!");
+		std::copy(levelIndices.begin(), levelIndices.end(), indexOut + nextIndex);
+		lods[level].firstIndex = nextIndex;
+		lods[level].numIndices = static_cast<uint32_t>(levelIndices.size());
+		nextIndex += lods[level].numIndices;
+	}
+	numLods = static_cast<uint32_t>(lodIndices.size());
+
+	return numVertices;
+}
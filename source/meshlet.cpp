@@ -0,0 +1,134 @@
+#include "meshlet.hpp"
+#include "vertexCache.hpp"
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	constexpr uint32_t NO_TRIANGLE = std::numeric_limits<uint32_t>::max();
+	constexpr uint32_t NO_MESHLET = std::numeric_limits<uint32_t>::max();
+
+	//unit normal of the triangle starting at corners, false if it has no area
+	bool triangleNormal(const Vertex* vertices, const Index* corners, glm::vec3& normal) {
+		glm::vec3 a = vertices[corners[0]].position, b = vertices[corners[1]].position, c = vertices[corners[2]].position;
+		glm::vec3 cross = glm::cross(b - a, c - a);
+		float length = glm::length(cross);
+		if (!(length > 0.0f)) return false;
+		normal = cross / length;
+		return true;
+	}
+
+	//bounds, bounding sphere and normal cone of meshlet's triangles in indices
+	void fitMeshlet(const Vertex* vertices, const Index* indices, Meshlet& meshlet) {
+		const Index* begin = indices + meshlet.firstIndex;
+		const Index* end = begin + meshlet.numIndices;
+		for (const Index* idx = begin; idx != end; idx++) meshlet.bounds.enclose(vertices[*idx].position);
+		meshlet.center = glm::vec3(meshlet.bounds.minX + meshlet.bounds.maxX, meshlet.bounds.minY + meshlet.bounds.maxY, meshlet.bounds.minZ + meshlet.bounds.maxZ) * 0.5f;
+		for (const Index* idx = begin; idx != end; idx++) meshlet.radius = std::max(meshlet.radius, glm::length(vertices[*idx].position - meshlet.center));
+
+		//cone axis is the average triangle normal, its half angle is set by the normal furthest from it
+		glm::vec3 normalSum = glm::vec3(0.0f), normal;
+		for (const Index* corners = begin; corners + 3 <= end; corners += 3) {
+			if (triangleNormal(vertices, corners, normal)) normalSum += normal;
+		}
+		float sumLength = glm::length(normalSum);
+		if (!(sumLength > 1e-6f)) return;
+		glm::vec3 axis = normalSum / sumLength;
+		float minDot = 1.0f;
+		for (const Index* corners = begin; corners + 3 <= end; corners += 3) {
+			if (triangleNormal(vertices, corners, normal)) minDot = std::min(minDot, glm::dot(axis, normal));
+		}
+		//a cone as wide as a hemisphere always has a triangle facing the viewer
+		if (minDot <= 0.0f) return;
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
+
+void buildMeshlets(const Vertex* vertices, uint32_t numVertices, Index* indices, uint32_t numIndices, uint32_t maxVertices, std::vector<Meshlet>& meshletsOut) {
+	const uint32_t numTriangles = numIndices / 3;
+	if (numTriangles == 0 || numVertices == 0) return;
+	maxVertices = std::max(maxVertices, 3U);
+	const uint32_t maxTriangles = meshletMaxTriangles(maxVertices);
+	VertexTriangles adjacency(indices, numTriangles * 3, numVertices);
+
+	std::vector<bool> used(numTriangles, false);
+	//meshlet each vertex was last added to, so membership needs no clearing between meshlets
+	std::vector<uint32_t> vertexMeshlet(numVertices, NO_MESHLET);
+	//triangles next to the current meshlet, used ones are only dropped when scanned
+	std::vector<uint32_t> candidates;
+	uint32_t scanCursor = 0;
+
+	std::vector<Index> output;
+	output.reserve(numTriangles * 3);
+	uint32_t meshletID = 0, meshletVertices = 0, meshletTriangles = 0;
+	size_t firstIndex = 0;
+
+	//vertices of triangle not yet in the current meshlet, counting a repeated corner once
+	auto newVertices = [&](uint32_t triangle) {
+		const Index* corners = indices + triangle * 3;
+		uint32_t count = 0;
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			if (vertexMeshlet[corners[corner]] == meshletID) continue;
+			if ((corner > 0 && corners[corner] == corners[0]) || (corner > 1 && corners[corner] == corners[1])) continue;
+			count++;
+		}
+		return count;
+	};
+	auto addTriangle = [&](uint32_t triangle) {
+		used[triangle] = true;
+		meshletTriangles++;
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			const Index vertex = indices[triangle * 3 + corner];
+			output.emplace_back(vertex);
+			if (vertexMeshlet[vertex] == meshletID) continue;
+			vertexMeshlet[vertex] = meshletID;
+			meshletVertices++;
+			for (uint32_t adjacent = adjacency.offsets[vertex]; adjacent < adjacency.offsets[vertex + 1]; adjacent++) {
+				if (!used[adjacency.triangles[adjacent]]) candidates.emplace_back(adjacency.triangles[adjacent]);
+			}
+		}
+	};
+	auto finishMeshlet = [&]() {
+		Meshlet meshlet{};
+		meshlet.firstIndex = static_cast<uint32_t>(firstIndex);
+		meshlet.numIndices = static_cast<uint32_t>(output.size() - firstIndex);
+		fitMeshlet(vertices, output.data(), meshlet);
+		meshletsOut.emplace_back(meshlet);
+		firstIndex = output.size();
+		meshletID++;
+		meshletVertices = 0;
+		meshletTriangles = 0;
+		candidates.clear();
+	};
+
+	for (uint32_t emitted = 0; emitted < numTriangles; emitted++) {
+		if (meshletTriangles == maxTriangles) finishMeshlet();
+
+		//neighbour sharing the most vertices with the meshlet that still fits
+		uint32_t best = NO_TRIANGLE, bestNew = 4;
+		size_t kept = 0;
+		for (size_t i = 0; i < candidates.size(); i++) {
+			const uint32_t triangle = candidates[i];
+			if (used[triangle]) continue;
+			candidates[kept++] = triangle;
+			uint32_t added = newVertices(triangle);
+			if (added < bestNew && meshletVertices + added <= maxVertices) {
+				best = triangle;
+				bestNew = added;
+			}
+		}
+		candidates.resize(kept);
+
+		if (best == NO_TRIANGLE) {
+			while (used[scanCursor]) scanCursor++;
+			best = scanCursor;
+			const bool halfFull = meshletTriangles * 2 >= maxTriangles || meshletVertices * 2 >= maxVertices;
+			if (meshletTriangles > 0 && (halfFull || meshletVertices + newVertices(best) > maxVertices)) finishMeshlet();
+		}
+		addTriangle(best);
+	}
+	if (meshletTriangles > 0) finishMeshlet();
+
+	std::copy(output.begin(), output.end(), indices);
+}
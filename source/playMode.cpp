@@ -8,6 +8,7 @@
 #include "vulkanCore.hpp"
 
 #include "triBufferTexturedMatrixVert.cpp"
+#include "triBufferCompactMatrixVert.cpp"
 #include "dotLightingFrag.cpp"
 #include "debugColorFrag.cpp"
 
@@ -16,8 +17,18 @@ PlayMode::PlayMode() : Mode(commandLineParameters.toModeParameters()) {
 	descriptorBindings = { {{ UNIFORM_BUFFER, VERTEX_STAGE, 1, {sizeof(UniformBuffer)}, -1 }, 
 							{ COMBINED_IMAGE_SAMPLER, FRAGMENT_STAGE, 1, {LINEAR_SAMPLER}, -1 }} };
 
-	shaders = {triBufferTexturedMatrixVert, dotLightingFrag, debugColorFrag};
-	shaderSizes = { triBufferTexturedMatrixVertSize, dotLightingFragSize, debugColorFragSize};
+	//the vertex shader decodes whichever layout vertices are uploaded in
+	activeVertexLayout = findVertexLayout(modeParameters.VERTEX_LAYOUT);
+	splitVertexPositions = modeParameters.SPLIT_POSITIONS;
+	if (splitVertexPositions && getVertexLayout().positionSize == 0) throw std::runtime_error("Vertex layout " + getVertexLayout().name + " can't split off its positions!");
+	if (getVertexLayout().name == "compact") {
+		shaders = { triBufferCompactMatrixVert, dotLightingFrag, debugColorFrag };
+		shaderSizes = { triBufferCompactMatrixVertSize, dotLightingFragSize, debugColorFragSize };
+	}
+	else {
+		shaders = {triBufferTexturedMatrixVert, dotLightingFrag, debugColorFrag};
+		shaderSizes = { triBufferTexturedMatrixVertSize, dotLightingFragSize, debugColorFragSize};
+	}
 	shaderStages = { {MAIN_RENDER, {{VERTEX_STAGE, 0}, {FRAGMENT_STAGE, 1}}}, 
 									{DEBUG_DRAW, {{VERTEX_STAGE, 0}, {FRAGMENT_STAGE, 2}}} };
 	pushConstantRanges = { {static_cast<ShaderStageT>(VERTEX_STAGE | FRAGMENT_STAGE), 0, static_cast<uint32_t>(sizeof(PushConsants))} };
@@ -28,6 +39,14 @@ PlayMode::PlayMode() : Mode(commandLineParameters.toModeParameters()) {
 		throw std::runtime_error("");
 	};
 	scene = Scene(modeParameters.SCENE_NAME, modeParameters);
+	if (activeVertexLayout != 0 || splitVertexPositions) {
+		uint32_t numVertices, vertexSize = 0;
+		vertexBufferSize(&numVertices, &vertexSize);
+		std::cout << "vertex layout " << getVertexLayout().name << " : " << numVertices << " vertices, " << static_cast<uint64_t>(numVertices) * sizeof(Vertex)
+			<< " -> " << static_cast<uint64_t>(numVertices) * vertexSize << " bytes";
+		if (splitVertexPositions) std::cout << ", " << static_cast<uint64_t>(numVertices) * vertexStreamStride(0) << " of them positions";
+		std::cout << std::endl;
+	}
 	
 	sceneCamera = scene.renderCameraID;
 	userCamera = scene.addOrbitCamera();
@@ -83,6 +102,9 @@ bool PlayMode::handleEvent(std::queue<Input::Event>& events, glm::uvec2 const& w
 }
 
 void PlayMode::update(float deltaTime, float totalTime) {
+	scene.updateStreaming(modeParameters);
+	if (modeParameters.HOT_RELOAD) scene.updateHotReload(modeParameters);
+
 	if (actionsDown[Input::DEBUG_VIEW] >= 0.9) {
 		debugViewMode = !debugViewMode;
 		scene.cullingCameraID = sceneCamera;
@@ -184,13 +206,16 @@ void PlayMode::draw(const App& core, VkCommandBuffer commandBuffer, uint32_t ima
 
 	for (const Scene::DrawParameters& drawParam : drawParams) {
 		core.updatePushConstants(commandBuffer, (ShaderStageT)(VERTEX_STAGE | FRAGMENT_STAGE), sizeof(PushConsants), 0, &drawParam.modelMat);
-		vkCmdDrawIndexed(commandBuffer, drawParam.mesh->numIndices, 1, drawParam.mesh->indexOffset, 0, 0);
+		vkCmdDrawIndexed(commandBuffer, drawParam.numIndices, 1, drawParam.indexOffset, static_cast<int32_t>(drawParam.mesh->vertexOffset), 0);
 	}
 
 	//draw bounds of each mesh for debugging purposes
 	if (modeParameters.ENABLE_DEBUG_VIEW && debugViewMode) {
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, core.pipelines.at(DEBUG_DRAW));
-		for (const Scene::DrawParameters& drawParam : drawParams) {
+		for (size_t drawIdx = 0; drawIdx < drawParams.size(); drawIdx++) {
+			const Scene::DrawParameters& drawParam = drawParams[drawIdx];
+			//with CLUSTER one mesh instance can be several draws, its bounds only need drawing once
+			if (drawIdx > 0 && drawParams[drawIdx - 1].mesh == drawParam.mesh && drawParams[drawIdx - 1].modelMat == drawParam.modelMat) continue;
 			core.updatePushConstants(commandBuffer, (ShaderStageT)(VERTEX_STAGE | FRAGMENT_STAGE), sizeof(PushConsants), 0, &drawParam.modelMat);
 			vkCmdDrawIndexed(commandBuffer, Mesh::DEBUG_BOUNDS_INDICES_SIZE, 1, Mesh::sharedDebugIndexOffset, Mesh::sharedDebugVertexOffset + drawParam.mesh->debugVertexOffset, 0);
 		}
@@ -2,10 +2,15 @@
 #include <algorithm>
 #include <stack>
 #include "utils.cpp"
+#include "vertexCache.hpp"
 #include "jsonParsing.cpp" //TODO why does linking fail if I don't include this
 #include <cmath>
 #include <algorithm>
 #include <random>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 glm::mat4 Transform::localToParent() const {
 	return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation)* glm::scale(glm::mat4(1.0), scale);
@@ -49,211 +54,531 @@ void Transform::matchOrbitControl(const OrbitControl& orbit) {
 	translation = orientationPosition.second;
 }
 
-bool isSimpleMaterial(Object obj) {
-	return !(obj.count("pbr") || obj.count("lambertian") || obj.count("environment") || obj.count("mirror"));
+bool isSimpleMaterial(const S72Material& material) {
+	return !(S72_HAS(material, "pbr") || S72_HAS(material, "lambertian") || S72_HAS(material, "environment") || S72_HAS(material, "mirror"));
 }
 
 
-Mesh Scene::initMesh(const Object& JSONObj, const ModeConstantParameters& parameters) {
-	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
+Mesh Scene::initMesh(const S72Mesh& s72Mesh) {
 	Mesh retMesh = Mesh();
 
-	Object attributes = JSONUtils::getVal(JSONObj, "attributes", OBJECT).toObject();
-	Object position = JSONUtils::getVal(attributes, "POSITION", OBJECT).toObject();
-	std::string sourceFile = JSONUtils::getVal(position, "src", STRING).toString();
+	auto position = std::find_if(s72Mesh.attributes.begin(), s72Mesh.attributes.end(), [](const S72Attribute& attribute) {
+		return S72::ATTRIBUTE_NAMES.find(attribute.name) == S72::POSITION;
+		});
+	if (position == s72Mesh.attributes.end()) {
+		std::cerr << "mesh " << s72Mesh.name << " has no POSITION attribute!";
+		throw std::runtime_error("");
+	}
+	std::string sourceFile = std::string(position->src);
 	
-	retMesh.loadMeshData(sourceFile, JSONObj, parameters);
+	//the data itself is read later by loadMeshes, along with every other mesh of the scene
+	tempMeshLoads.emplace_back(tmpMeshLoad{ &s72Mesh, sourceFile });
+	tempSourceFiles.emplace_back(Mesh::findFile(sourceFile));
+	if (S72_HAS(s72Mesh, "indices") && s72Mesh.indices.src != position->src) tempSourceFiles.emplace_back(Mesh::findFile(std::string(s72Mesh.indices.src)));
+
+	return retMesh;
+};
 
-	//add vertices and indices for wireframe cube representing the bounds of the mesh
+void Scene::loadMeshes(const ModeConstantParameters& parameters) {
+	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
+	if (CHECK_VALIDITY) assert(tempMeshLoads.size() == static_cast<size_t>(meshes.dataEnd() - meshes.dataBegin()));
+
+	//meshes that read the same bytes are only read once, see geometrySources
+	//hot reload rewrites each mesh's range in place, so there every mesh keeps its own
+	const bool shareGeometry = !parameters.HOT_RELOAD;
+	std::vector<uint32_t> geometrySource = shareGeometry ? geometrySources(tempMeshLoads) : std::vector<uint32_t>{};
+
+	//sizing pass, every mesh that is read gets its own slot at the end of the global buffers, sized from the scene
+	//file alone, so they are grown once and each thread reads straight into its slot without touching shared state
+	std::vector<MeshSize> slotSize(tempMeshLoads.size());
+	std::vector<size_t> slotVertex(tempMeshLoads.size()), slotIndex(tempMeshLoads.size());
+	const size_t firstVertex = vertices.size(), firstIndex = indices.size();
+	size_t planVertices = firstVertex, planIndices = firstIndex;
+	for (size_t meshIdx = 0; meshIdx < tempMeshLoads.size(); meshIdx++) {
+		if (shareGeometry && geometrySource[meshIdx] != meshIdx) continue;
+		const tmpMeshLoad& load = tempMeshLoads[meshIdx];
+		slotSize[meshIdx] = Mesh::plannedSize(*load.s72Mesh, parameters);
+		slotVertex[meshIdx] = planVertices;
+		slotIndex[meshIdx] = planIndices;
+		planVertices += slotSize[meshIdx].vertices;
+		planIndices += slotSize[meshIdx].indices;
+	}
+	//debug bounds are appended once every mesh is loaded, see the scene constructor
 	if (parameters.ENABLE_DEBUG_VIEW) {
+		vertices.reserve(planVertices + 8 * tempMeshLoads.size());
+		indices.reserve(planIndices + Mesh::DEBUG_BOUNDS_INDICES_SIZE);
+	}
+	vertices.resize(planVertices);
+	indices.resize(planIndices);
+
+	//fill pass, indices are local to their mesh's first vertex, so slots are packed below without touching them
+	std::vector<uint64_t> hashes(tempMeshLoads.size());
+	std::vector<MeshLoadReport> loadReports(tempMeshLoads.size());
+	std::vector<std::vector<Meshlet>> slotMeshlets(parameters.CLUSTER ? tempMeshLoads.size() : 0);
+	parallelFor(tempMeshLoads.size(), resolveThreadCount(parameters.LOAD_THREADS), [&](size_t meshIdx) {
+		if (shareGeometry && geometrySource[meshIdx] != meshIdx) return;
+		const tmpMeshLoad& load = tempMeshLoads[meshIdx];
+		Mesh& mesh = *(meshes.dataBegin() + meshIdx);
+		slotSize[meshIdx].vertices = mesh.loadMeshData(load.sourceFile, *load.s72Mesh, parameters, 
+			vertices.data() + slotVertex[meshIdx], indices.data() + slotIndex[meshIdx], slotSize[meshIdx], 
+			parameters.CLUSTER ? &slotMeshlets[meshIdx] : nullptr, &loadReports[meshIdx]);
+		slotSize[meshIdx].indices = mesh.totalIndices();
+		//same as MeshStaging::hash
+		if (shareGeometry) hashes[meshIdx] = hashXXH64(indices.data() + slotIndex[meshIdx], slotSize[meshIdx].indices * sizeof(Index),
+			hashXXH64(vertices.data() + slotVertex[meshIdx], slotSize[meshIdx].vertices * sizeof(Vertex)));
+		});
+
+	MeshLoadReport total{};
+	for (size_t meshIdx = 0; meshIdx < loadReports.size(); meshIdx++) {
+		const MeshLoadReport& report = loadReports[meshIdx];
+		total += report;
+		if (!parameters.PRINT_DEBUG_OUTPUT) continue;
+		const std::string_view name = tempMeshLoads[meshIdx].s72Mesh->name;
+		if (report.vertexCache.before.triangles > 0) {
+			std::cout << "vertex cache : " << name << " ACMR " << report.vertexCache.before.acmr() << " -> " << report.vertexCache.after.acmr() 
+				<< ", ATVR " << report.vertexCache.before.atvr() << " -> " << report.vertexCache.after.atvr() << std::endl;
+		}
+		if (report.strips.listIndices > 0) {
+			std::cout << "stripify : " << name << " " << report.strips.listIndices << " -> " << report.strips.stripIndices << " indices in " 
+				<< report.strips.strips << " strips" << std::endl;
+		}
+		if (report.lods.lods > 0) {
+			const Mesh& mesh = *(meshes.dataBegin() + meshIdx);
+			std::cout << "lod : " << name << " " << mesh.numIndices;
+			for (uint32_t lod = 0; lod < mesh.numLods; lod++) std::cout << " -> " << mesh.lods[lod].numIndices << " (error " << mesh.lods[lod].error << ")";
+			std::cout << " indices" << std::endl;
+		}
+	}
+	if (parameters.OPTIMIZE_VERTEX_CACHE) {
+		std::cout << "vertex cache : ACMR " << total.vertexCache.before.acmr() << " -> " << total.vertexCache.after.acmr() << ", ATVR " << total.vertexCache.before.atvr() 
+			<< " -> " << total.vertexCache.after.atvr() << " over " << total.vertexCache.before.triangles << " triangles, FIFO cache of " << VERTEX_CACHE_SIZE << std::endl;
+	}
+	if (parameters.STRIPIFY) {
+		std::cout << "stripify : " << total.strips.listIndices << " list indices -> " << total.strips.stripIndices << " strip indices in " << total.strips.strips 
+			<< " strips, " << total.strips.listIndices * sizeof(Index) << " -> " << total.strips.stripIndices * sizeof(Index) << " bytes" << std::endl;
+	}
+	if (Mesh::lodLevels(parameters) > 1) {
+		std::cout << "lod : " << total.lods.lods << " LODs, " << total.lods.baseIndices << " full detail + " << total.lods.lodIndices << " LOD list indices" << std::endl;
+	}
 
-		std::string name = JSONUtils::getVal(JSONObj, "name", STRING).toString();
-		uint32_t nameHash = std::hash<std::string>{}(name);
-		std::mt19937 randomGen(nameHash); // Seed the Mersenne Twister engine
-		std::uniform_int_distribution<uint32_t> distribution(0, std::numeric_limits<uint32_t>::max()); 
-		uint32_t randomColor = distribution(randomGen); // Generate a random uint32_t
-		randomColor |= 0xFF; //make sure alpha is 1
-
-		Bounds b = retMesh.bounds;
-		b.minX -= Mesh::BOUNDS_INFLATE_FACTOR; b.minY -= Mesh::BOUNDS_INFLATE_FACTOR; b.minZ -= Mesh::BOUNDS_INFLATE_FACTOR;
-		b.maxX += Mesh::BOUNDS_INFLATE_FACTOR; b.maxY += Mesh::BOUNDS_INFLATE_FACTOR; b.maxZ += Mesh::BOUNDS_INFLATE_FACTOR;
-		//sanity check, make sure Bounds b was copied locally and is not a reference
-		if (CHECK_VALIDITY) assert(Mesh::BOUNDS_INFLATE_FACTOR == 0.0f || (retMesh.bounds.minX > b.minX));
-
-		/*
-		*    7------6
-		*   / |    /|
-		*  4------5 |
-		*  |  |   | |
-		*  |  3---| 2
-		*  | /    |/
-		*  0------1
-		*/
-
-		std::vector<glm::vec3> boundsPositions = { /*0*/{b.minX, b.minY, b.minZ}, /*1*/ {b.maxX, b.minY, b.minZ},
-												   /*2*/{b.maxX, b.maxY, b.minZ}, /*3*/ {b.minX, b.maxY, b.minZ},
-			                                       /*4*/{b.minX, b.minY, b.maxZ}, /*5*/ {b.maxX, b.minY, b.maxZ},
-												   /*6*/{b.maxX, b.maxY, b.maxZ}, /*7*/ {b.minX, b.maxY, b.maxZ} };
-		Vertex vert{};
-		vert.color = randomColor;// randomColor;
-		retMesh.debugVertexOffset = tempDebugVertices.size();
-		for (glm::vec3 pos : boundsPositions) {
-			vert.position = pos;
-			tempDebugVertices.emplace_back(vert);
+	//meshes read from different bytes can still turn out identical, e.g. the same object exported to two files
+	if (shareGeometry) {
+		auto sameSlot = [&](size_t a, size_t b) {
+			return slotSize[a].vertices == slotSize[b].vertices && slotSize[a].indices == slotSize[b].indices &&
+				memcmp(vertices.data() + slotVertex[a], vertices.data() + slotVertex[b], slotSize[a].vertices * sizeof(Vertex)) == 0 &&
+				memcmp(indices.data() + slotIndex[a], indices.data() + slotIndex[b], slotSize[a].indices * sizeof(Index)) == 0;
+		};
+		std::unordered_map<uint64_t, uint32_t> firstWithHash{};
+		for (uint32_t meshIdx = 0; meshIdx < tempMeshLoads.size(); meshIdx++) {
+			if (geometrySource[meshIdx] != meshIdx) continue;
+			auto [first, inserted] = firstWithHash.try_emplace(hashes[meshIdx], meshIdx);
+			if (inserted || !sameSlot(first->second, meshIdx)) continue;
+			geometrySource[meshIdx] = first->second;
 		}
 	}
-	
-	return retMesh;
+
+	//then packed down over the space toIndexed and shared geometry left unused, in the order the graph first
+	//referenced them so offsets match a serial load. slots only ever move down, so this is done in place
+	size_t nextVertex = firstVertex, nextIndex = firstIndex;
+	for (size_t meshIdx = 0; meshIdx < tempMeshLoads.size(); meshIdx++) {
+		Mesh& mesh = *(meshes.dataBegin() + meshIdx);
+		//sources always come first, so their geometry is already packed
+		if (shareGeometry && geometrySource[meshIdx] != meshIdx) mesh.shareMeshData(*(meshes.dataBegin() + geometrySource[meshIdx]));
+		else {
+			const MeshSize& size = slotSize[meshIdx];
+			if (parameters.HOT_RELOAD) tempMeshVertexRanges.push_back(BufferRange{ static_cast<uint32_t>(nextVertex), size.vertices });
+			memmove(vertices.data() + nextVertex, vertices.data() + slotVertex[meshIdx], size.vertices * sizeof(Vertex));
+			memmove(indices.data() + nextIndex, indices.data() + slotIndex[meshIdx], size.indices * sizeof(Index));
+			mesh.indexOffset = static_cast<uint32_t>(nextIndex);
+			mesh.vertexOffset = static_cast<uint32_t>(nextVertex);
+			if (parameters.CLUSTER) appendMeshlets(mesh, slotMeshlets[meshIdx]);
+			nextVertex += size.vertices;
+			nextIndex += size.indices;
+		}
+		if (parameters.ENABLE_DEBUG_VIEW) addDebugBounds(mesh, tempMeshLoads[meshIdx].s72Mesh->name, parameters);
+	}
+	vertices.resize(nextVertex);
+	indices.resize(nextIndex);
+	tempMeshLoads.clear();
+}
+
+void Scene::appendMeshlets(Mesh& mesh, const std::vector<Meshlet>& meshMeshlets) {
+	mesh.meshletOffset = static_cast<uint32_t>(meshlets.size());
+	mesh.numMeshlets = static_cast<uint32_t>(meshMeshlets.size());
+	meshlets.insert(meshlets.end(), meshMeshlets.begin(), meshMeshlets.end());
+}
+
+//for each mesh, idx of the first mesh with the same Mesh::geometryKey, which is itself if there is none before it
+std::vector<uint32_t> Scene::geometrySources(const std::vector<tmpMeshLoad>& loads) {
+	std::vector<uint32_t> sources(loads.size());
+	std::unordered_map<std::string, uint32_t> firstWithKey{};
+	for (uint32_t meshIdx = 0; meshIdx < loads.size(); meshIdx++) {
+		sources[meshIdx] = firstWithKey.try_emplace(Mesh::geometryKey(*loads[meshIdx].s72Mesh), meshIdx).first->second;
+	}
+	return sources;
+}
+
+//add vertices for wireframe cube representing the bounds of the mesh
+void Scene::addDebugBounds(Mesh& mesh, std::string_view name, const ModeConstantParameters& parameters) {
+	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
+	uint32_t nameHash = std::hash<std::string_view>{}(name);
+	std::mt19937 randomGen(nameHash); // Seed the Mersenne Twister engine
+	std::uniform_int_distribution<uint32_t> distribution(0, std::numeric_limits<uint32_t>::max()); 
+	uint32_t randomColor = distribution(randomGen); // Generate a random uint32_t
+	randomColor |= 0xFF; //make sure alpha is 1
+
+	Bounds b = mesh.bounds;
+	b.minX -= Mesh::BOUNDS_INFLATE_FACTOR; b.minY -= Mesh::BOUNDS_INFLATE_FACTOR; b.minZ -= Mesh::BOUNDS_INFLATE_FACTOR;
+	b.maxX += Mesh::BOUNDS_INFLATE_FACTOR; b.maxY += Mesh::BOUNDS_INFLATE_FACTOR; b.maxZ += Mesh::BOUNDS_INFLATE_FACTOR;
+	//sanity check, make sure Bounds b was copied locally and is not a reference
+	if (CHECK_VALIDITY) assert(Mesh::BOUNDS_INFLATE_FACTOR == 0.0f || (mesh.bounds.minX > b.minX));
+
+	/*
+	*    7------6
+	*   / |    /|
+	*  4------5 |
+	*  |  |   | |
+	*  |  3---| 2
+	*  | /    |/
+	*  0------1
+	*/
+
+	std::vector<glm::vec3> boundsPositions = { /*0*/{b.minX, b.minY, b.minZ}, /*1*/ {b.maxX, b.minY, b.minZ},
+											   /*2*/{b.maxX, b.maxY, b.minZ}, /*3*/ {b.minX, b.maxY, b.minZ},
+		                                       /*4*/{b.minX, b.minY, b.maxZ}, /*5*/ {b.maxX, b.minY, b.maxZ},
+											   /*6*/{b.maxX, b.maxY, b.maxZ}, /*7*/ {b.minX, b.maxY, b.maxZ} };
+	Vertex vert{};
+	vert.color = randomColor;// randomColor;
+	mesh.debugVertexOffset = tempDebugVertices.size();
+	for (glm::vec3 pos : boundsPositions) {
+		vert.position = pos;
+		tempDebugVertices.emplace_back(vert);
+	}
+}
+
+//everything the background loader needs, owned separately from Scene so a Scene can be moved while meshes stream
+struct Scene::MeshStream {
+	struct Load {
+		S72Mesh s72Mesh;
+		std::string sourceFile;
+	};
+	struct Finished {
+		uint32_t meshIdx = 0;
+		Mesh mesh{}; //only bounds, numIndices and lods are filled in
+		MeshStaging staging{};
+		uint64_t hash = 0;
+	};
+	//geometry already in the global buffers, by MeshStaging::hash, so identical meshes from different bytes share it
+	struct ResidentGeometry {
+		uint32_t meshIdx = 0;
+		uint32_t firstVertex = 0;
+		uint32_t numVertices = 0;
+	};
+
+	JSONParser sceneParser{}; //owns the file buffer the S72Mesh names and paths view
+	std::string scenePath{};
+	ModeConstantParameters parameters{};
+	std::vector<Load> loads{};
+	//meshes with the same Mesh::geometryKey as an earlier one aren't loaded, they become resident with it
+	std::vector<std::vector<uint32_t>> sharers{};
+	std::unordered_multimap<uint64_t, ResidentGeometry> residentGeometry{};
+	//for saveCache once every mesh is resident
+	std::vector<std::string> sourceFiles{};
+	size_t verticesBase = 0;
+	size_t indicesBase = 0;
+	size_t numResident = 0;
+
+	std::mutex finishedMutex{};
+	std::vector<Finished> finished{};
+	std::exception_ptr failure = nullptr;
+	std::atomic<bool> cancel = false;
+	std::thread worker{};
+
+	~MeshStream() {
+		cancel = true;
+		if (worker.joinable()) worker.join();
+	}
 };
 
-Material Scene::initMaterial(const Object& JSONobj, const ModeConstantParameters& parameters) {
+void Scene::startMeshStream(JSONParser&& sceneParser, const std::string& scenePath, const ModeConstantParameters& parameters) {
+	meshStream = std::make_shared<MeshStream>();
+	MeshStream& stream = *meshStream;
+	//meshes are appended to vertices / indices after the device buffers are created
+	retainVertexIndexData = true;
+	stream.sceneParser = std::move(sceneParser);
+	stream.scenePath = scenePath;
+	stream.parameters = parameters;
+	stream.sourceFiles = tempSourceFiles;
+	stream.verticesBase = tempVerticesBase;
+	stream.indicesBase = tempIndicesBase;
+	stream.loads.reserve(tempMeshLoads.size());
+	for (const tmpMeshLoad& load : tempMeshLoads) stream.loads.emplace_back(MeshStream::Load{ *load.s72Mesh, load.sourceFile });
+	std::vector<uint32_t> geometrySource = geometrySources(tempMeshLoads);
+	stream.sharers.resize(tempMeshLoads.size());
+	for (uint32_t meshIdx = 0; meshIdx < geometrySource.size(); meshIdx++) {
+		if (geometrySource[meshIdx] != meshIdx) stream.sharers[geometrySource[meshIdx]].push_back(meshIdx);
+	}
+	tempMeshLoads.clear();
+
+	//the shared debug bounds indices go first, each mesh appends its own debug vertices when it arrives
+	if (parameters.ENABLE_DEBUG_VIEW) {
+		Mesh::sharedDebugIndexOffset = indices.size();
+		Mesh::sharedDebugVertexOffset = 0;
+		indices.insert(indices.end(), Mesh::debugIndices.begin(), Mesh::debugIndices.end());
+	}
+
+	//the device buffers are created before meshes arrive, so size them for the most every mesh could add
+	uint64_t maxVertices = vertices.size(), maxIndices = indices.size();
+	for (size_t meshIdx = 0; meshIdx < stream.loads.size(); meshIdx++) {
+		(meshes.dataBegin() + meshIdx)->resident = false;
+		maxVertices += parameters.ENABLE_DEBUG_VIEW ? 8 : 0;
+		if (geometrySource[meshIdx] != meshIdx) continue;
+		MeshSize size = Mesh::plannedSize(stream.loads[meshIdx].s72Mesh, parameters);
+		maxVertices += size.vertices;
+		maxIndices += size.indices;
+	}
+	if (maxVertices > std::numeric_limits<uint32_t>::max() || maxIndices > std::numeric_limits<uint32_t>::max()) {
+		throw std::runtime_error("Scene too large to stream!");
+	}
+	reservedVertices = static_cast<uint32_t>(maxVertices);
+	reservedIndices = static_cast<uint32_t>(maxIndices);
+	vertices.reserve(maxVertices);
+	indices.reserve(maxIndices);
+
+	size_t numThreads = resolveThreadCount(parameters.LOAD_THREADS);
+	stream.worker = std::thread([&stream, numThreads, geometrySource = std::move(geometrySource)]() {
+		try {
+			parallelFor(stream.loads.size(), numThreads, [&](size_t meshIdx) {
+				if (stream.cancel || geometrySource[meshIdx] != meshIdx) return;
+				const MeshStream::Load& load = stream.loads[meshIdx];
+				MeshStream::Finished done{};
+				done.meshIdx = static_cast<uint32_t>(meshIdx);
+				done.mesh.loadMeshData(load.sourceFile, load.s72Mesh, stream.parameters, done.staging);
+				done.hash = done.staging.hash();
+				std::lock_guard<std::mutex> lock(stream.finishedMutex);
+				stream.finished.emplace_back(std::move(done));
+				});
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(stream.finishedMutex);
+			stream.failure = std::current_exception();
+		}
+		});
+}
+
+bool Scene::updateStreaming(const ModeConstantParameters& parameters) {
+	if (!meshStream) return false;
+	MeshStream& stream = *meshStream;
+
+	std::vector<MeshStream::Finished> finished{};
+	std::exception_ptr failure = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(stream.finishedMutex);
+		std::swap(finished, stream.finished);
+		failure = stream.failure;
+	}
+	if (failure) {
+		meshStream.reset();
+		std::rethrow_exception(failure);
+	}
+
+	//everything that arrived since the last call is appended as one contiguous range, uploaded in one batch
+	uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+	uint32_t firstIndex = static_cast<uint32_t>(indices.size());
+	auto makeResident = [&](uint32_t meshIdx) {
+		Mesh& mesh = *(meshes.dataBegin() + meshIdx);
+		if (parameters.ENABLE_DEBUG_VIEW) {
+			//sharedDebugVertexOffset is 0 while streaming, so debugVertexOffset is absolute
+			addDebugBounds(mesh, stream.loads[meshIdx].s72Mesh.name, parameters);
+			mesh.debugVertexOffset = static_cast<uint32_t>(vertices.size());
+			vertices.insert(vertices.end(), tempDebugVertices.begin(), tempDebugVertices.end());
+			tempDebugVertices.clear();
+		}
+		mesh.resident = true;
+		stream.numResident++;
+	};
+	for (MeshStream::Finished& done : finished) {
+		const std::vector<uint32_t>& sharers = stream.sharers[done.meshIdx];
+		if (vertices.size() + done.staging.vertices.size() + (parameters.ENABLE_DEBUG_VIEW ? 8 * (1 + sharers.size()) : 0) > reservedVertices ||
+			indices.size() + done.staging.indices.size() > reservedIndices) {
+			throw std::runtime_error("Streamed mesh does not fit in the reserved vertex / index buffers!");
+		}
+		Mesh& mesh = *(meshes.dataBegin() + done.meshIdx);
+		//geometry identical to a mesh that is already resident is shared rather than appended again
+		auto [sameHash, sameHashEnd] = stream.residentGeometry.equal_range(done.hash);
+		auto resident = std::find_if(sameHash, sameHashEnd, [&](const auto& entry) {
+			const Mesh& other = *(meshes.dataBegin() + entry.second.meshIdx);
+			if (other.totalIndices() != done.staging.indices.size() || entry.second.numVertices != done.staging.vertices.size()) return false;
+			if (!std::equal(done.staging.vertices.begin(), done.staging.vertices.end(), vertices.begin() + entry.second.firstVertex, vertices.begin() + entry.second.firstVertex + done.staging.vertices.size())) return false;
+			return std::equal(done.staging.indices.begin(), done.staging.indices.end(), indices.begin() + other.indexOffset);
+			});
+		if (resident != sameHashEnd) mesh.shareMeshData(*(meshes.dataBegin() + resident->second.meshIdx));
+		else {
+			mesh.bounds = done.mesh.bounds;
+			mesh.boundingSphere = done.mesh.boundingSphere;
+			mesh.orientedBounds = done.mesh.orientedBounds;
+			mesh.numIndices = done.mesh.numIndices;
+			mesh.lods = done.mesh.lods;
+			mesh.numLods = done.mesh.numLods;
+			stream.residentGeometry.emplace(done.hash, MeshStream::ResidentGeometry{ done.meshIdx, static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(done.staging.vertices.size()) });
+			mesh.appendMeshData(done.staging);
+			if (parameters.CLUSTER) appendMeshlets(mesh, done.staging.meshlets);
+		}
+		makeResident(done.meshIdx);
+		for (uint32_t sharer : sharers) {
+			(meshes.dataBegin() + sharer)->shareMeshData(mesh);
+			makeResident(sharer);
+		}
+	}
+	if (vertices.size() > firstVertex) dirtyVertexRanges.emplace_back(BufferRange{ firstVertex, static_cast<uint32_t>(vertices.size()) - firstVertex });
+	if (indices.size() > firstIndex) dirtyIndexRanges.emplace_back(BufferRange{ firstIndex, static_cast<uint32_t>(indices.size()) - firstIndex });
+
+	if (stream.numResident < stream.loads.size()) return true;
+
+	if (parameters.SCENE_CACHE) {
+		tempSourceFiles = std::move(stream.sourceFiles);
+		tempVerticesBase = stream.verticesBase;
+		tempIndicesBase = stream.indicesBase;
+		saveCache(stream.scenePath, parameters);
+		tempSourceFiles.clear();
+	}
+	meshStream.reset();
+	return false;
+}
+
+Material Scene::initMaterial(const S72Material& s72Material, const ModeConstantParameters& parameters) {
 	Material retMaterial = Material();
 
 	return retMaterial;
 }
 
-Camera Scene::initCamera(const Object& JSONObj, const ModeConstantParameters& parameters) {
-	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
-	if (CHECK_VALIDITY) assert(JSONUtils::getVal(JSONObj, "type", STRING).toString() == "CAMERA");
+Camera Scene::initCamera(const S72Camera& s72Camera, const ModeConstantParameters& parameters) {
 	Camera retCamera = Camera();
 
-	if (JSONObj.count("perspective")) {
-		const Object& perspectiveObj = JSONUtils::getVal(JSONObj, "perspective", OBJECT).toObject();
-		if (perspectiveObj.count("aspect")) retCamera.aspect =  JSONUtils::getVal(perspectiveObj, "aspect", NUMBER).toNumber().toFloatDestructive();
-		if (perspectiveObj.count("vfov")) retCamera.vfov = JSONUtils::getVal(perspectiveObj, "vfov", NUMBER).toNumber().toFloatDestructive();
-		if (perspectiveObj.count("near")) retCamera.nearPlane = JSONUtils::getVal(perspectiveObj, "near", NUMBER).toNumber().toFloatDestructive();
-		if (perspectiveObj.count("far")) retCamera.farPlane = JSONUtils::getVal(perspectiveObj, "far", NUMBER).toNumber().toFloatDestructive();
+	if (S72_HAS(s72Camera, "perspective")) {
+		const S72Perspective& perspective = s72Camera.perspective;
+		if (S72_HAS(perspective, "aspect")) retCamera.aspect = perspective.aspect;
+		if (S72_HAS(perspective, "vfov")) retCamera.vfov = perspective.vfov;
+		if (S72_HAS(perspective, "near")) retCamera.nearPlane = perspective.nearPlane;
+		if (S72_HAS(perspective, "far")) retCamera.farPlane = perspective.farPlane;
 	}
 
 	return retCamera;
 }
 
-Environment Scene::initEnvironment(const Object& JSONObj, const ModeConstantParameters& parameters) {
+Environment Scene::initEnvironment(const S72Environment& s72Environment, const ModeConstantParameters& parameters) {
 	Environment retEnvironment = Environment();
 
 	return retEnvironment;
 }
 
-Light Scene::initLight(const Object &JSONObj, const ModeConstantParameters& parameters) {
+Light Scene::initLight(const S72Light& s72Light, const ModeConstantParameters& parameters) {
 	Light retLight = Light();
 
 	return retLight;
 }
 
-Driver Scene::initDriver(const Object &JSONObj, entitySize_t entityID, const ModeConstantParameters& parameters) {
+//entityID is set once the graph is built, see Scene::Scene
+Driver Scene::initDriver(S72Driver&& s72Driver, const ModeConstantParameters& parameters) {
 	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
 	Driver retDriver;
 
-	retDriver.entityID = entityID;
-	retDriver.values = JSONUtils::getFloats(JSONObj, "values");
-	retDriver.times = JSONUtils::getFloats(JSONObj, "times");
-	//set as not static
-	graph.get(entityID).entity.setIsStatic(false);
+	retDriver.values = std::move(s72Driver.values);
+	retDriver.times = std::move(s72Driver.times);
 	
-	std::string channel = JSONUtils::getVal(JSONObj, "channel", STRING).toString();
-	if (channel == "rotation") {
+	switch (S72::DRIVER_CHANNELS.find(s72Driver.channel)) {
+	case S72::ROTATION_CHANNEL:
 		retDriver.setChannelRotation(true);
 		if (CHECK_VALIDITY) assert((retDriver.values.size() % 4) == 0);
-	}
-	else if (channel == "translation") {
+		break;
+	case S72::TRANSLATION_CHANNEL:
 		retDriver.setChannelTranslation(true);
 		if (CHECK_VALIDITY) assert((retDriver.values.size() % 3) == 0);
-	}
-	else {
-		if (CHECK_VALIDITY) assert((channel == "scale") && ((retDriver.values.size() % 3) == 0));
+		break;
+	default:
+		if (CHECK_VALIDITY) assert((s72Driver.channel == "scale") && ((retDriver.values.size() % 3) == 0));
 		retDriver.setChannelScale(true);
 	}
 	if (CHECK_VALIDITY) assert(retDriver.values.size() % retDriver.times.size() == 0);
 
-	std::string interpolation = JSONUtils::getVal(JSONObj, "interpolation", STRING).toString();
-	if (interpolation == "LINEAR") {
+	switch (S72::DRIVER_INTERPOLATIONS.find(s72Driver.interpolation)) {
+	case S72::LINEAR:
 		retDriver.setInterpolationLinear(true);
-	}
-	else if (interpolation == "SLERP") {
+		break;
+	case S72::SLERP:
 		retDriver.setInterpolationSlerp(true);
-	}
-	else {
-		if (CHECK_VALIDITY) assert(interpolation == "STEP");
+		break;
+	default:
+		if (CHECK_VALIDITY) assert(s72Driver.interpolation == "STEP");
 		retDriver.setInterpolationStep(true);
 	}
 
 	return retDriver;
 }
 
-Scene::SceneNode Scene::initNode(const Object& JSONObj, const ModeConstantParameters& parameters, const entitySize_t parent) {
+Scene::SceneNode Scene::initNode(atom_t nodeAtom, const ModeConstantParameters& parameters, const entitySize_t parent) {
 	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
-	if (CHECK_VALIDITY) assert(JSONObj.count("type") && JSONUtils::getVal(JSONObj, "type", STRING).toString() == "NODE");
+	if (CHECK_VALIDITY) assert(tempNodes.count(nodeAtom));
+	const tmpNode& node = tempNodes.at(nodeAtom);
+	const S72Node& nodeData = node.data;
 
 	SceneNode retNode = SceneNode();
 	retNode.parent = parent;
-	//all .s72 transform defaults set in Transform constructor, so if the values don't exist in file we don't need the else clause
-	if (JSONObj.count("translation")) {
-		retNode.transform.translation = JSONUtils::getVec3(JSONObj, "translation", CHECK_VALIDITY);
-	}
-	if (JSONObj.count("rotation")) {
-		retNode.transform.rotation = JSONUtils::getQuat(JSONObj, "rotation", CHECK_VALIDITY);
-	}
-	if (JSONObj.count("scale")) {
-		retNode.transform.scale = JSONUtils::getVec3(JSONObj, "scale", CHECK_VALIDITY);
-	}
+	//all .s72 transform defaults are set in S72Node, so missing values don't need special casing
+	retNode.transform.translation = nodeData.translation;
+	retNode.transform.rotation = nodeData.rotation;
+	retNode.transform.scale = nodeData.scale;
 	//MESH CASE
-	if (JSONObj.count("mesh")) {
-		std::string meshName = JSONUtils::getVal(JSONObj, "mesh", STRING).toString();
+	if (node.mesh != NO_ATOM) {
+		const uint64_t meshKey = tmpComponentKey(MESH, node.mesh);
 		retNode.entity.setHasMesh(true);
 		if (CHECK_VALIDITY) assert(retNode.entity.hasMesh());
-		if (tempComponents.count({MESH, meshName })) {
-			uint32_t idx = tempComponents[{MESH, meshName}];
+		if (tempComponents.count(meshKey)) {
+			uint32_t idx = tempComponents[meshKey];
 			meshes.insertExisting(retNode.entity, idx);
 		}
 		else {
-			if (CHECK_VALIDITY) assert(tempGraph.count({MESH, meshName }));
-			tempGraph[{MESH, meshName}].references++;
-			tmpNodeData tempMeshData = tempGraph[{MESH, meshName}];
-			const Object& meshObj = tempMeshData.object;
+			if (CHECK_VALIDITY) assert(tempMeshes.count(node.mesh));
 			//load the new mesh
-			Mesh newMesh = initMesh(meshObj, parameters);
+			Mesh newMesh = initMesh(tempMeshes.at(node.mesh).data);
 			int idx = (meshes.insert(retNode.entity, newMesh));
-			tempComponents[{MESH, meshName}] = idx;
+			tempComponents[meshKey] = idx;
+			//tempMeshLoads is parallel to meshes' _data, see loadMeshes
+			if (CHECK_VALIDITY) assert(static_cast<size_t>(idx) + 1 == tempMeshLoads.size());
 		}
-		//MATERIAL CASE
-		const Object& meshObj = tempGraph[{MESH, meshName}].object;
-		if (JSONObj.count("material")) {
-			std::string materialName = JSONUtils::getVal(meshObj, "material", STRING).toString();
+		//MATERIAL CASE, material is named by the mesh object
+		const tmpMesh& mesh = tempMeshes.at(node.mesh);
+		if (S72_HAS(mesh.data, "material")) {
+			const uint64_t materialKey = tmpComponentKey(MATERIAL, mesh.material);
 			//no need to set hasMaterial flag cause it's assumed all meshes have a material
-			if (tempComponents.count({MATERIAL, materialName })) {
-				uint32_t idx = tempComponents[{MATERIAL, materialName}];
+			if (tempComponents.count(materialKey)) {
+				uint32_t idx = tempComponents[materialKey];
 				materials.insertExisting(retNode.entity, idx);
 			}
 			else {
-				if (CHECK_VALIDITY) assert(tempGraph.count({ MATERIAL, materialName }));
-				tempGraph[{MATERIAL, materialName}].references++;
-				tmpNodeData tempMeshData = tempGraph[{MATERIAL, materialName}];
-				const Object& materialObj = tempMeshData.object;
-				int idx = (materials.insert(retNode.entity, initMaterial(materialObj, parameters)));
-				tempComponents[{MATERIAL, materialName}] = idx;
+				if (CHECK_VALIDITY) assert(tempMaterials.count(mesh.material));
+				int idx = (materials.insert(retNode.entity, initMaterial(tempMaterials.at(mesh.material), parameters)));
+				tempComponents[materialKey] = idx;
 			}
 		}
 
 	}
 	//CAMERA CASE
-	if (JSONObj.count("camera")) {
-		std::string cameraName = JSONUtils::getVal(JSONObj, "camera", STRING).toString();
+	if (node.camera != NO_ATOM) {
+		const uint64_t cameraKey = tmpComponentKey(CAMERA, node.camera);
 		retNode.entity.setHasCamera(true);
 		if(CHECK_VALIDITY) assert(retNode.entity.hasCamera());
-		if (tempComponents.count({ CAMERA, cameraName })) {
-			uint32_t idx = tempComponents[{CAMERA, cameraName}];
+		if (tempComponents.count(cameraKey)) {
+			uint32_t idx = tempComponents[cameraKey];
 			cameras.insertExisting(retNode.entity, idx);
 		}
 		else {
-			if(CHECK_VALIDITY)assert(tempGraph.count({CAMERA, cameraName}));
-			tempGraph[{CAMERA, cameraName}].references++;
-			tmpNodeData tempMeshData = tempGraph[{CAMERA, cameraName}];
-			const Object& cameraObj = tempMeshData.object;
+			if(CHECK_VALIDITY)assert(tempCameras.count(node.camera));
 			//load the new camera
-			int idx = (cameras.insert(retNode.entity, initCamera(cameraObj, parameters)));
-			tempComponents[{CAMERA, cameraName}] = idx;
+			int idx = (cameras.insert(retNode.entity, initCamera(tempCameras.at(node.camera), parameters)));
+			tempComponents[cameraKey] = idx;
 			//setting camera from command line
-			if (cameraName == parameters.START_CAMERA_NAME) {
+			if (node.camera == tempStartCamera) {
 				renderCameraID = retNode.entity.getID();
 				cullingCameraID = retNode.entity.getID();
 			}
@@ -264,64 +589,55 @@ Scene::SceneNode Scene::initNode(const Object& JSONObj, const ModeConstantParame
 		}
 	}
 	//ENVIRONMENT CASE
-	if (JSONObj.count("environment")) {
-		std::string environmentName = JSONUtils::getVal(JSONObj, "environment", STRING).toString();
+	if (node.environment != NO_ATOM) {
+		const uint64_t environmentKey = tmpComponentKey(ENVIRONMENT, node.environment);
 		retNode.entity.setHasCamera(true);
-		if (tempComponents.count({ ENVIRONMENT, environmentName })) {
-			uint32_t idx = tempComponents[{ENVIRONMENT, environmentName}];
+		if (tempComponents.count(environmentKey)) {
+			uint32_t idx = tempComponents[environmentKey];
 			cameras.insertExisting(retNode.entity, idx);
 		}
 		else {
-			if (CHECK_VALIDITY) assert(tempGraph.count({ ENVIRONMENT, environmentName }));
-			tempGraph[{ENVIRONMENT, environmentName}].references++;
-			tmpNodeData tempMeshData = tempGraph[{ENVIRONMENT, environmentName}];
-			const Object& environmentObj = tempMeshData.object;
+			if (CHECK_VALIDITY) assert(tempEnvironments.count(node.environment));
 			//load the new camera
-			int idx = (environments.insert(retNode.entity, initEnvironment(environmentObj, parameters)));
-			tempComponents[{ENVIRONMENT, environmentName}] = idx;
+			int idx = (environments.insert(retNode.entity, initEnvironment(tempEnvironments.at(node.environment), parameters)));
+			tempComponents[environmentKey] = idx;
 		}
 	}
 	//LIGHT CASE
-	if (JSONObj.count("light")) {
-		std::string lightName = JSONUtils::getVal(JSONObj, "light", STRING).toString();
+	if (node.light != NO_ATOM) {
+		const uint64_t lightKey = tmpComponentKey(LIGHT, node.light);
 		retNode.entity.setHasCamera(true);
-		if (tempComponents.count({ LIGHT, lightName })) {
-			uint32_t idx = tempComponents[{LIGHT, lightName}];
+		if (tempComponents.count(lightKey)) {
+			uint32_t idx = tempComponents[lightKey];
 			lights.insertExisting(retNode.entity, idx);
 		}
 		else {
-			if (CHECK_VALIDITY) assert(tempGraph.count({LIGHT, lightName}));
-			tempGraph[{LIGHT, lightName}].references++;
-			tmpNodeData tempMeshData = tempGraph[{LIGHT, lightName}];
-			const Object& environmentObj = tempMeshData.object;
+			if (CHECK_VALIDITY) assert(tempLights.count(node.light));
 			//load the new camera
-			int idx = (environments.insert(retNode.entity, initEnvironment(environmentObj, parameters)));
-			tempComponents[{LIGHT, lightName}] = idx;
+			int idx = (lights.insert(retNode.entity, initLight(tempLights.at(node.light), parameters)));
+			tempComponents[lightKey] = idx;
 		}
 	}
 
-	//guaranteed that node has name
-	std::string nodeName = JSONUtils::getVal(JSONObj, "name", STRING).toString();
 	//add current scene node to temp components map
 	graph.insert(retNode.entity, retNode);
 	//idx in temp component is entity ID NOT idx in _data array
-	tempComponents[{NODE, nodeName}] = static_cast<uint32_t>(retNode.entity.getID());
+	tempComponents[tmpComponentKey(NODE, nodeAtom)] = static_cast<uint32_t>(retNode.entity.getID());
 	//TODO don't update values of retNode directly from here on since it won;t get updated in scene graph
 
 
 	//NOW INIT CHILDREN
 	//TODO change retNode to refernce to stop repeated calls to graph.get() 
-	if (JSONObj.count("children")) {
-		std::vector<std::string> childNames = JSONUtils::getIndicesNames(JSONObj, "children", CHECK_VALIDITY);
+	if (!node.children.empty()) {
+		const std::vector<atom_t>& childAtoms = node.children;
 		
-		if (childNames.size() > 0 && tempComponents.count({ NODE, childNames[0] })) {
-			entitySize_t id = static_cast<entitySize_t>(tempComponents[{NODE, childNames[0]}]);
+		if (childAtoms.size() > 0 && tempComponents.count(tmpComponentKey(NODE, childAtoms[0]))) {
+			entitySize_t id = static_cast<entitySize_t>(tempComponents[tmpComponentKey(NODE, childAtoms[0])]);
 			graph.get(retNode.entity).child = id;
 			if (CHECK_VALIDITY) assert(graph.contains(id));
 		}
-		else if (childNames.size() > 0) {
-			if(CHECK_VALIDITY) assert(tempGraph.count({NODE, childNames[0]}));
-			graph.get(retNode.entity).child = initNode(tempGraph[{NODE, childNames[0]}].object, parameters, retNode.entity.getID()).entity.getID();
+		else if (childAtoms.size() > 0) {
+			graph.get(retNode.entity).child = initNode(childAtoms[0], parameters, retNode.entity.getID()).entity.getID();
 		}
 		else {
 			return graph.get(retNode.entity);
@@ -330,16 +646,15 @@ Scene::SceneNode Scene::initNode(const Object& JSONObj, const ModeConstantParame
 		if(CHECK_VALIDITY) assert(graph.contains(graph.get(retNode.entity).child));
 		entitySize_t curSceneNodeID = graph.get(retNode.entity).child;
 		entitySize_t siblingID;
-		for (uint32_t i = 1; i < childNames.size(); i++) {
-			const std::string& childName = childNames[i];
-			if (tempComponents.count({ NODE, childName })) {
-				siblingID = static_cast<entitySize_t>(tempComponents[{NODE, childName}]);
+		for (uint32_t i = 1; i < childAtoms.size(); i++) {
+			atom_t childAtom = childAtoms[i];
+			if (tempComponents.count(tmpComponentKey(NODE, childAtom))) {
+				siblingID = static_cast<entitySize_t>(tempComponents[tmpComponentKey(NODE, childAtom)]);
 				graph.get(curSceneNodeID).sibling = siblingID;
 				if (CHECK_VALIDITY) assert(graph.contains(siblingID));
 			}
 			else {
-				if(CHECK_VALIDITY) assert(tempGraph.count({NODE, childName}));
-				siblingID = initNode(tempGraph[{NODE, childName}].object, parameters, retNode.parent).entity.getID();
+				siblingID = initNode(childAtom, parameters, retNode.parent).entity.getID();
 				graph.get(curSceneNodeID).sibling = siblingID;
 			}
 			curSceneNodeID = siblingID;
@@ -397,102 +712,178 @@ entitySize_t Scene::addOrbitCamera(entitySize_t parent, const OrbitControl& orbi
 	return entityID;
 }
 
+//decodes every element of parser's range, only touches chunk so ranges can be read concurrently
+void Scene::readObjects(JSONParser& parser, tmpObjectChunk& chunk, const ModeConstantParameters& parameters) {
+	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
+	for (size_t i = 0; parser.nextElement(); i++) {
+		if (CHECK_VALIDITY) assert(parser.peekType() == OBJECT);
+		//type may come after other members, peek it so the object can be decoded in a single pass
+		const std::string_view type = parser.peekMemberString("type");
+		switch (static_cast<objType>(S72::OBJECT_TYPES.find(type))) {
+		case SCENE:
+			S72::decode(parser, chunk.scenes.emplace_back());
+			break;
+		case NODE:
+			S72::decode(parser, chunk.nodes.emplace_back());
+			break;
+		case MESH:
+			S72::decode(parser, chunk.meshes.emplace_back());
+			break;
+		case CAMERA:
+			S72::decode(parser, chunk.cameras.emplace_back());
+			break;
+		case DRIVER: {
+			S72Driver driver{};
+			S72::decode(parser, driver);
+			if (CHECK_VALIDITY) assert(S72_HAS(driver, "node"));
+			std::string_view nodeName = driver.node;
+			chunk.drivers.emplace_back(std::make_pair(nodeName, initDriver(std::move(driver), parameters)));
+			break;
+		}
+		case DATA:
+			//not referenced by anything yet, dropped
+			parser.skipValue();
+			break;
+		case MATERIAL:
+			S72::decode(parser, chunk.materials.emplace_back());
+			break;
+		case ENVIRONMENT:
+			S72::decode(parser, chunk.environments.emplace_back());
+			break;
+		case LIGHT:
+			S72::decode(parser, chunk.lights.emplace_back());
+			break;
+		default:
+			std::cerr << "unrecognized object type in element " << i << " of scene file array range!";
+			assert(false);
+			parser.skipValue();
+		}
+	}
+}
+
+//first object of a given name wins, same as inserting them one at a time in file order
+//runs serially in file order, so atoms are handed out the same way regardless of how the array was split
+void Scene::mergeObjects(tmpObjectChunk& chunk) {
+	for (S72Node& node : chunk.nodes) {
+		auto [it, inserted] = tempNodes.try_emplace(tempAtoms.intern(node.name));
+		if (!inserted) continue;
+		tmpNode& merged = it->second;
+		merged.mesh = internReference(node.mesh);
+		merged.camera = internReference(node.camera);
+		merged.environment = internReference(node.environment);
+		merged.light = internReference(node.light);
+		merged.children.reserve(node.children.size());
+		for (std::string_view child : node.children) merged.children.push_back(tempAtoms.intern(child));
+		merged.data = std::move(node);
+	}
+	for (S72Mesh& mesh : chunk.meshes) {
+		auto [it, inserted] = tempMeshes.try_emplace(tempAtoms.intern(mesh.name));
+		if (!inserted) continue;
+		it->second.material = internReference(mesh.material);
+		it->second.data = std::move(mesh);
+	}
+	for (const S72Material& material : chunk.materials) tempMaterials.insert({ tempAtoms.intern(material.name), material });
+	for (const S72Camera& camera : chunk.cameras) tempCameras.insert({ tempAtoms.intern(camera.name), camera });
+	for (const S72Environment& environment : chunk.environments) tempEnvironments.insert({ tempAtoms.intern(environment.name), environment });
+	for (const S72Light& light : chunk.lights) tempLights.insert({ tempAtoms.intern(light.name), light });
+	for (auto& [nodeName, driver] : chunk.drivers) tempDrivers.emplace_back(tempAtoms.intern(nodeName), std::move(driver));
+}
+
+void Scene::parseObjects(JSONParser& parser, std::vector<std::string_view>& rootNames, bool& hasRoots, const ModeConstantParameters& parameters) {
+	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
+	//objects are decoded straight into their typed S72 structs, no DOM or tape of the document is built
+	//names are views into the parser's file buffer
+	[[maybe_unused]]
+	bool isArray = parser.beginArray();
+	if (CHECK_VALIDITY) assert(isArray);
+
+	[[maybe_unused]]
+	bool hasVersion = parser.nextElement();
+	if (CHECK_VALIDITY) assert(hasVersion && parser.peekType() == STRING);
+	fileVersion = std::string(parser.readString());
+
+	//elements are split into byte-balanced ranges using only the structural index, each range is decoded on its
+	//own thread and the results are merged back in file order, so the outcome matches a serial load
+	std::vector<JSONParser> ranges = parser.splitArray(resolveThreadCount(parameters.LOAD_THREADS));
+	std::vector<tmpObjectChunk> chunks(ranges.size());
+	parallelFor(ranges.size(), ranges.size(), [&](size_t rangeIdx) {
+		readObjects(ranges[rangeIdx], chunks[rangeIdx], parameters);
+		});
+
+	rootNames.clear();
+	hasRoots = false;
+	size_t objectCount = 0;
+	for (const tmpObjectChunk& chunk : chunks) {
+		objectCount += chunk.nodes.size() + chunk.meshes.size() + chunk.materials.size() + chunk.cameras.size() + chunk.environments.size() + chunk.lights.size();
+	}
+	tempAtoms.reserve(objectCount);
+	for (tmpObjectChunk& chunk : chunks) {
+		//a later SCENE object replaces an earlier one
+		for (S72Scene& scene : chunk.scenes) {
+			hasRoots = S72_HAS(scene, "roots");
+			rootNames = std::move(scene.roots);
+		}
+		mergeObjects(chunk);
+	}
+	chunks.clear();
+	//the only name looked up by string after merging
+	tempStartCamera = tempAtoms.find(parameters.START_CAMERA_NAME);
+}
+
 Scene::Scene(std::string filename, const ModeConstantParameters& parameters) {
 	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
 	if (filename == "") throw std::runtime_error("No scene name given to scene constructor!");
 
 	bool fileExists = false;
+	std::string scenePath;
 	JSONParser sceneParser;
 	for (std::string tryPath : std::vector<std::string>{filename, filename + ".s72", "scenes\\" + filename, "scenes\\"+filename+".s72"}) {
-		sceneParser = JSONParser(tryPath, &fileExists);
-		if (fileExists) break;
+		if (!std::ifstream(tryPath, std::ios::binary).good()) continue;
+		scenePath = tryPath;
+		break;
 	}
-	if (!fileExists) throw std::runtime_error("Failed to find {scene}, {scene}.s72, scenes/{scene}, or scenes/{scene}.s72!");
-
-
-	Value retSceneJSON = sceneParser.parse();
-
-	if (CHECK_VALIDITY) assert(retSceneJSON.type == ARRAY);
+	if (scenePath.empty()) throw std::runtime_error("Failed to find {scene}, {scene}.s72, scenes/{scene}, or scenes/{scene}.s72!");
 
-	std::vector<Value> sceneArr = retSceneJSON.toArray();
-	size_t arraySize = sceneArr.size();
+	//a cache whose sources are unchanged already holds everything below, nothing is parsed or read from the mesh files
+	//hot reload needs the object names, which the cache doesn't keep
+	if (parameters.SCENE_CACHE && !parameters.HOT_RELOAD && loadCache(scenePath, parameters)) return;
 
-	if (CHECK_VALIDITY) assert(sceneArr[0].type == STRING);
-	fileVersion = sceneArr[0].toString();
+	sceneParser = JSONParser(scenePath, &fileExists);
+	if (!fileExists) throw std::runtime_error("Failed to open " + scenePath + "!");
+	tempSourceFiles.emplace_back(scenePath);
+	tempVerticesBase = vertices.size();
+	tempIndicesBase = indices.size();
 
-	//only used for scene construction, cleared at end
-	std::string sceneName = "";
-	for (size_t i = 1; i < arraySize; i++) {
-		Value curVal = sceneArr[i];
-		if (CHECK_VALIDITY) assert(curVal.type == OBJECT);
-		Object curObj = curVal.toObject();
 
-		Value typeV = curObj.at("type");
-		if (CHECK_VALIDITY) assert(typeV.type == STRING);
-		const std::string type = typeV.toString();
-		std::string name = JSONUtils::getVal(curObj, "name", STRING).toString();
-		if (type == "SCENE") {
-			sceneName = name;
-			tempGraph.insert({ {SCENE, name}, {curObj, 1} });
-		}
-		else if (type == "MESH") {
-			tempGraph.insert({ {MESH, name}, {curObj, 0} });
-		}
-		else if (type == "LIGHT") {
-			tempGraph.insert({ {LIGHT, name}, {curObj, 0} });
-		}
-		else if (type == "NODE") {
-			tempGraph.insert({ {NODE, name}, {curObj, 0} });
-		}
-		else if (type == "CAMERA") {
-			tempGraph.insert({ {CAMERA, name}, {curObj, 0} });
-		}
-		else if (type == "DRIVER") {
-			tempDrivers.emplace_back(std::make_pair(name, curObj));
-		}
-		else if (type == "DATA") {
-			tempGraph.insert({ {DATA, name}, { curObj, 0} });
-		}
-		else if (type == "MATERIAL") {
-			tempGraph.insert({ {MATERIAL, name}, {curObj, 0} });
-		}
-		else if (type == "ENVIRONMENT") {
-			tempGraph.insert({ {ENVIRONMENT, name}, {curObj, 0} });
-		}
-		else {
-			std::cerr << "unrecognized object type in element " << i << "of scene file array!";
-			assert(false);
-		}
-	}
+	//the parser outlives construction, so names stay valid until the temp maps are cleared
+	std::vector<std::string_view> rootNames{};
+	bool sceneHasRoots = false;
+	parseObjects(sceneParser, rootNames, sceneHasRoots, parameters);
 	
-	//now decend starting from root node, which is SCENE node
-	tmpNodeData sceneNode = tempGraph[{SCENE, sceneName}];
-	if (!sceneNode.object.count("roots")) {
-		tempGraph.clear();
-		tempComponents.clear();
+	//now decend starting from roots of SCENE node
+	if (!sceneHasRoots) {
+		clearTempObjects();
+		tempSourceFiles.clear();
 		return;
 	}
 
-	std::vector<std::string> rootNames = JSONUtils::getIndicesNames(sceneNode.object, "roots");
 	if (rootNames.size() > 0) {
-		if (CHECK_VALIDITY) assert(tempGraph.count({NODE, rootNames[0] }));
-		rootID = initNode(tempGraph[{NODE, rootNames[0]}].object, parameters, std::numeric_limits<entitySize_t>().max()).entity.getID();
+		rootID = initNode(tempAtoms.intern(rootNames[0]), parameters, std::numeric_limits<entitySize_t>().max()).entity.getID();
 		if (CHECK_VALIDITY) assert(graph.contains(rootID));
 
 		entitySize_t curSceneNodeID = rootID;
 		for (uint32_t i = 1; i < rootNames.size(); i++) {
-			const std::string& rootName = rootNames[i];
+			atom_t rootAtom = tempAtoms.intern(rootNames[i]);
 			entitySize_t siblingID;
-			if (tempComponents.count({ NODE, rootName })) {
-				siblingID = static_cast<entitySize_t>(tempComponents[{NODE, rootName}]);
+			if (tempComponents.count(tmpComponentKey(NODE, rootAtom))) {
+				siblingID = static_cast<entitySize_t>(tempComponents[tmpComponentKey(NODE, rootAtom)]);
 				graph.get(curSceneNodeID).sibling = siblingID;
 				if (CHECK_VALIDITY) assert(graph.contains(siblingID));
 				//check that assignment actually appears in the graph
 				if (CHECK_VALIDITY) assert(graph.get(curSceneNodeID).sibling == siblingID);
 			}
 			else {
-				if (CHECK_VALIDITY) assert(tempGraph.count({NODE, rootName }));
-				siblingID = initNode(tempGraph[{NODE, rootName}].object, parameters, std::numeric_limits<entitySize_t>().max()).entity.getID();
+				siblingID = initNode(rootAtom, parameters, std::numeric_limits<entitySize_t>().max()).entity.getID();
 				if (CHECK_VALIDITY) assert(graph.contains(siblingID));
 				graph.get(curSceneNodeID).sibling = siblingID;
 				//check that assignment actually appears in the graph
@@ -502,19 +893,24 @@ Scene::Scene(std::string filename, const ModeConstantParameters& parameters) {
 		}
 	}
 
+	//when streaming, the constructor returns with the graph, cameras and drivers ready and meshes not yet resident
+	//hot reload patches meshes in the ranges they were loaded into, so they are always loaded up front
+	if (parameters.STREAM_MESHES && !parameters.HOT_RELOAD && !tempMeshLoads.empty()) startMeshStream(std::move(sceneParser), scenePath, parameters);
+	else loadMeshes(parameters);
+
 	//now insert drivers
-	for (const auto& [driverName, driverObject] : tempDrivers) {
-		if (CHECK_VALIDITY) assert(driverObject.count("node"));
-		std::string nodeName = JSONUtils::getVal(driverObject, "node", STRING).toString();
-		if (CHECK_VALIDITY) assert(tempComponents.count({ NODE, nodeName}));
-		entitySize_t entityID = tempComponents[{NODE, nodeName}];
+	for (auto& [nodeAtom, driver] : tempDrivers) {
+		if (CHECK_VALIDITY) assert(tempComponents.count(tmpComponentKey(NODE, nodeAtom)));
+		entitySize_t entityID = tempComponents[tmpComponentKey(NODE, nodeAtom)];
 
+		driver.entityID = entityID;
+		graph.get(entityID).entity.setIsStatic(false);
 		graph.get(entityID).entity.setIsDriverAnimated(true);
-		drivers.insert(entityID, initDriver(driverObject, entityID, parameters));
+		drivers.insert(entityID, std::move(driver));
 	}
 
-	//now insert debug bounds vertices and indices into true vertex/index buffer
-	if (parameters.ENABLE_DEBUG_VIEW) {
+	//now insert debug bounds vertices and indices into true vertex/index buffer, streamed meshes add their own
+	if (parameters.ENABLE_DEBUG_VIEW && !meshStream) {
 		if (CHECK_VALIDITY) assert(tempDebugVertices.size() % 8 == 0);
 
 		Mesh::sharedDebugIndexOffset = indices.size();
@@ -525,13 +921,30 @@ Scene::Scene(std::string filename, const ModeConstantParameters& parameters) {
 		indices.insert(indices.end(), Mesh::debugIndices.begin(), Mesh::debugIndices.end());
 	}
 
-	tempGraph.clear();
-	tempComponents.clear();
-	tempDrivers.clear();
+	//streamed scenes are cached once their last mesh arrives, see updateStreaming
+	if (parameters.SCENE_CACHE && !meshStream) saveCache(scenePath, parameters);
+	if (parameters.HOT_RELOAD) startHotReload(scenePath, rootNames, parameters);
+
+	clearTempObjects();
 	tempDebugVertices.clear();
+	tempSourceFiles.clear();
+	tempMeshVertexRanges.clear();
 	return;
 }
 
+void Scene::clearTempObjects() {
+	tempNodes.clear();
+	tempMeshes.clear();
+	tempMaterials.clear();
+	tempCameras.clear();
+	tempEnvironments.clear();
+	tempLights.clear();
+	tempComponents.clear();
+	tempDrivers.clear();
+	tempAtoms.clear();
+	tempStartCamera = NO_ATOM;
+}
+
 template<typename T>
 T interpolateLinearly(T A, T B, float t) {
 	return (1.0f - t) * A + t * B;
@@ -637,10 +1050,73 @@ bool Scene::frustumCull(const std::vector<glm::vec4>& frustumPlanes, const Bound
 	return true;
 }
 
+bool Scene::frustumCull(const std::vector<glm::vec4>& frustumPlanes, const Mesh& mesh, const glm::mat4& modelMat) {
+	//a non uniform scale stretches the sphere by at most modelMat's largest axis scale
+	const glm::vec3 center = glm::vec3(modelMat * glm::vec4(mesh.boundingSphere.center, 1.0f));
+	const float scale = std::max({ glm::length(glm::vec3(modelMat[0])), glm::length(glm::vec3(modelMat[1])), glm::length(glm::vec3(modelMat[2])) });
+	const float radius = mesh.boundingSphere.radius * scale;
+	bool straddles = false;
+	for (const glm::vec4& plane : frustumPlanes) {
+		const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		if (distance < -radius) return false;
+		straddles |= distance < radius;
+	}
+	if (!straddles) return true;
+
+	//the box's half axes after modelMat, a plane misses the box if its center is further behind it than the box reaches
+	const OrientedBounds& box = mesh.orientedBounds;
+	const glm::vec3 boxCenter = glm::vec3(modelMat * glm::vec4(box.center, 1.0f));
+	const glm::mat3 linear = glm::mat3(modelMat);
+	const glm::vec3 halfAxes[3] = { linear * (box.axes[0] * box.halfExtents.x), linear * (box.axes[1] * box.halfExtents.y), linear * (box.axes[2] * box.halfExtents.z) };
+	for (const glm::vec4& plane : frustumPlanes) {
+		const glm::vec3 normal = glm::vec3(plane);
+		const float reach = std::abs(glm::dot(normal, halfAxes[0])) + std::abs(glm::dot(normal, halfAxes[1])) + std::abs(glm::dot(normal, halfAxes[2]));
+		if (glm::dot(normal, boxCenter) + plane.w < -reach) return false;
+	}
+	return true;
+}
+
+void Scene::drawMeshlets(std::vector<DrawParameters>& drawParams, const std::vector<glm::vec4>& frustumPlanes, glm::vec3 eye, const glm::mat4& modelMat,
+	std::vector<Mesh>::const_iterator mesh, const ModeConstantParameters& parameters) {
+	//meshlet cones are in the mesh's local space, which side of a triangle the eye is on doesn't change under modelMat
+	const glm::vec3 localEye = glm::vec3(glm::inverse(modelMat) * glm::vec4(eye, 1.0f));
+	bool extendLast = false;
+	for (uint32_t meshletIdx = mesh->meshletOffset; meshletIdx < mesh->meshletOffset + mesh->numMeshlets; meshletIdx++) {
+		const Meshlet& meshlet = meshlets[meshletIdx];
+		if (meshlet.backfacing(localEye) || (parameters.FRUSTUM_CULLING && !frustumCull(frustumPlanes, meshlet.bounds, modelMat))) {
+			extendLast = false;
+			continue;
+		}
+		//a mesh's meshlets are back to back in the index buffer, so a run of visible ones is one draw
+		if (extendLast) drawParams.back().numIndices += meshlet.numIndices;
+		else drawParams.emplace_back(DrawParameters(modelMat, mesh, mesh->indexOffset + meshlet.firstIndex, meshlet.numIndices));
+		extendLast = true;
+	}
+}
+
+uint32_t Scene::selectLod(const Mesh& mesh, float screenSize, uint32_t lastLod) {
+	auto switchSize = [](uint32_t lod) { return LOD_SCREEN_SIZE / static_cast<float>(1U << (lod - 1)); };
+	uint32_t lod = std::min(lastLod, mesh.numLods);
+	while (lod < mesh.numLods && screenSize < switchSize(lod + 1) * (1.0f - LOD_HYSTERESIS)) lod++;
+	while (lod > 0 && screenSize > switchSize(lod) * (1.0f + LOD_HYSTERESIS)) lod--;
+	return lod;
+}
+
 void Scene::drawScene(std::vector<DrawParameters>& drawParams, glm::mat4& viewTransform, glm::mat4& projTransform, const ModeConstantParameters& parameters) {
-	//scene transform
-	std::stack <std::pair<glm::mat4, entitySize_t>> drawStack{};
-	drawStack.push({glm::mat4(1.0f), rootID}); //populates mat4's diagonal with 1.0f (ie identity matrix)
+	//scene transform, and the path key of the node's parent, see instanceLods
+	struct DrawEntry {
+		glm::mat4 transform;
+		entitySize_t entity;
+		uint64_t parentPath;
+	};
+	std::stack<DrawEntry> drawStack{};
+	drawStack.push({glm::mat4(1.0f), rootID, 0}); //populates mat4's diagonal with 1.0f (ie identity matrix)
+	auto pathKey = [](uint64_t parentPath, entitySize_t entity) {
+		uint64_t key = parentPath * 0x9E3779B97F4A7C15ULL + entity + 1;
+		key ^= key >> 33;
+		key *= 0xFF51AFD7ED558CCDULL;
+		return key ^ (key >> 33);
+	};
 	//assumes no loops in scene tree
 	bool cameraSet = false;
 
@@ -666,22 +1142,37 @@ void Scene::drawScene(std::vector<DrawParameters>& drawParams, glm::mat4& viewTr
 	}
 
 	glm::mat4 cullingMatrix = glm::transpose(frustumProj * frustumView);
+	//normalized so a plane gives distances in world units, for the bounding sphere test
+	auto normalizePlane = [](glm::vec4 plane) { return plane / glm::length(glm::vec3(plane)); };
 	const std::vector<glm::vec4> frustumPlanes = {
 		// left, right, bottom, top
-		(cullingMatrix[3] + cullingMatrix[0]),
-		(cullingMatrix[3] - cullingMatrix[0]),
-		(cullingMatrix[3] + cullingMatrix[1]),
-		(cullingMatrix[3] - cullingMatrix[1]),
+		normalizePlane(cullingMatrix[3] + cullingMatrix[0]),
+		normalizePlane(cullingMatrix[3] - cullingMatrix[0]),
+		normalizePlane(cullingMatrix[3] + cullingMatrix[1]),
+		normalizePlane(cullingMatrix[3] - cullingMatrix[1]),
 		// near, far
-		(cullingMatrix[3] + cullingMatrix[2]),
-		(cullingMatrix[3] - cullingMatrix[2]),
+		normalizePlane(cullingMatrix[3] + cullingMatrix[2]),
+		normalizePlane(cullingMatrix[3] - cullingMatrix[2]),
 	};
+	//meshlets are cone culled against the culling camera too
+	const glm::vec3 cullingEye = glm::vec3(glm::inverse(frustumView)[3]);
+
+	//LODs are picked for the render camera, which the graph walk below may only reach after some of the meshes
+	glm::vec3 lodEye = cullingEye;
+	float lodTanHalfFov = std::tan(Camera().vfov * 0.5f);
+	if (Mesh::lodLevels(parameters) > 1) {
+		if (sceneHasCamera()) {
+			lodEye = glm::vec3(glm::inverse(getParentToLocalFullSingular(renderCameraID))[3]);
+			lodTanHalfFov = std::tan(cameras.get(renderCameraID).vfov * 0.5f);
+		}
+	}
 
 	while (!drawStack.empty()) {
-		std::pair<glm::mat4, entitySize_t> nodeEntry = drawStack.top();
+		DrawEntry nodeEntry = drawStack.top();
 		drawStack.pop();
-		glm::mat4 curTransform = nodeEntry.first;
-		entitySize_t curEntityID = nodeEntry.second;
+		glm::mat4 curTransform = nodeEntry.transform;
+		entitySize_t curEntityID = nodeEntry.entity;
+		const uint64_t curPath = pathKey(nodeEntry.parentPath, curEntityID);
 		const SceneNode& curSceneNode = graph.get(curEntityID);
 		const Entity& curEntity = curSceneNode.entity;
 		
@@ -689,13 +1180,13 @@ void Scene::drawScene(std::vector<DrawParameters>& drawParams, glm::mat4& viewTr
 
 		//TODO check if all these explicity copy constructors + 1 one std::move saves time than just all copy constructors
 		if (curSceneNode.hasSibling()) {
-			drawStack.push({ glm::mat4(curTransform), curSceneNode.sibling });
+			drawStack.push({ glm::mat4(curTransform), curSceneNode.sibling, nodeEntry.parentPath });
 		}
 
 		curTransform = curTransform * curSceneNode.transform.localToParent();
 		//since we insert child before sibling in EntityComponents, more spatial localtiy if we add child to stack last
 		if (curSceneNode.hasChild()) {
-			drawStack.push({ glm::mat4(curTransform), curSceneNode.child});
+			drawStack.push({ glm::mat4(curTransform), curSceneNode.child, curPath });
 		}
 
 		if (!cameraSet && curEntity.hasCamera() && (sceneHasCamera() && curEntityID == renderCameraID)) {
@@ -709,8 +1200,23 @@ void Scene::drawScene(std::vector<DrawParameters>& drawParams, glm::mat4& viewTr
 		
 		if (curEntity.hasMesh()) {
 			auto meshIt = meshes.dataIterator(curEntityID);
-			if (!parameters.FRUSTUM_CULLING || frustumCull(frustumPlanes, meshIt->bounds, curTransform)) {
-				drawParams.emplace_back(DrawParameters(curTransform, meshIt));
+			//meshes still streaming in have nothing in the vertex / index buffers yet
+			if (meshIt->resident && (!parameters.FRUSTUM_CULLING || frustumCull(frustumPlanes, *meshIt, curTransform))) {
+				uint32_t lod = 0;
+				if (meshIt->numLods > 0) {
+					//bounding sphere, scaled by modelMat's largest axis scale
+					glm::vec3 center = glm::vec3(curTransform * glm::vec4(meshIt->boundingSphere.center, 1.0f));
+					float scale = std::max({ glm::length(glm::vec3(curTransform[0])), glm::length(glm::vec3(curTransform[1])), glm::length(glm::vec3(curTransform[2])) });
+					float radius = scale * meshIt->boundingSphere.radius;
+					float distance = glm::length(center - lodEye);
+					float screenSize = distance > radius ? radius / (distance * lodTanHalfFov) : std::numeric_limits<float>::max();
+					uint8_t& lastLod = instanceLods[curPath];
+					lod = selectLod(*meshIt, screenSize, lastLod);
+					lastLod = static_cast<uint8_t>(lod);
+				}
+				if (lod > 0) drawParams.emplace_back(DrawParameters(curTransform, meshIt, meshIt->indexOffset + meshIt->lods[lod - 1].firstIndex, meshIt->lods[lod - 1].numIndices));
+				else if (parameters.CLUSTER && meshIt->numMeshlets > 0) drawMeshlets(drawParams, frustumPlanes, cullingEye, curTransform, meshIt, parameters);
+				else drawParams.emplace_back(DrawParameters(curTransform, meshIt, meshIt->indexOffset, meshIt->numIndices));
 			}
 		}
 	}
@@ -0,0 +1,407 @@
+#include "sceneCache.hpp"
+#include "scene.hpp"
+#include "utils.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+std::string S72B::cachePath(const std::string& scenePath) {
+	if (scenePath.size() >= 4 && scenePath.compare(scenePath.size() - 4, 4, ".s72") == 0) return scenePath + "b";
+	return scenePath + ".s72b";
+}
+
+uint64_t S72B::hashBytes(const char* data, size_t size) {
+	return hashXXH64(data, size);
+}
+
+namespace {
+	//SceneNode without the entity allocation its constructor does
+	struct NodeRecord {
+		Transform transform{};
+		uint32_t id = 0;
+		uint32_t flags = 0;
+		uint32_t sibling = 0;
+		uint32_t child = 0;
+		uint32_t parent = 0;
+	};
+
+	constexpr entitySize_t NO_ENTITY = std::numeric_limits<entitySize_t>().max();
+
+	//same bits as Driver's private flags, rebuilt through its accessors so Driver doesn't have to expose them
+	uint32_t driverFlags(const Driver& driver) {
+		return (driver.isChannelTranslation() << 0) | (driver.isChannelScale() << 1) | (driver.isChannelRotation() << 2) |
+			(driver.isInterpolationStep() << 3) | (driver.isInterpolationLinear() << 4) | (driver.isInterpolationSlerp() << 5);
+	}
+
+	void setDriverFlags(Driver& driver, uint32_t flags) {
+		driver.setChannelTranslation(flags & (0x1U << 0));
+		driver.setChannelScale(flags & (0x1U << 1));
+		driver.setChannelRotation(flags & (0x1U << 2));
+		driver.setInterpolationStep(flags & (0x1U << 3));
+		driver.setInterpolationLinear(flags & (0x1U << 4));
+		driver.setInterpolationSlerp(flags & (0x1U << 5));
+	}
+
+	//loader options that change the geometry written to the global buffers
+	uint32_t meshOptions(const ModeConstantParameters& parameters) {
+		uint32_t clusterSize = parameters.CLUSTER ? static_cast<uint32_t>(std::max(parameters.CLUSTER_SIZE, 0)) : 0;
+		return (parameters.OPTIMIZE_VERTEX_CACHE << 0) | (parameters.STRIPIFY << 1) | (parameters.CLUSTER << 2) | (Mesh::lodLevels(parameters) << 3) | (clusterSize << 8);
+	}
+
+	bool sourceStat(const std::string& path, uint64_t& size, int64_t& writeTime) {
+		std::error_code error;
+		size = std::filesystem::file_size(path, error);
+		if (error) return false;
+		writeTime = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+		return !error;
+	}
+
+	bool sourceHash(const std::string& path, uint64_t& hash) {
+		MappedFile file;
+		if (!file.open(path)) return false;
+		hash = S72B::hashBytes(file.data(), file.size());
+		return true;
+	}
+
+	struct CacheWriter {
+		std::vector<char> bytes{};
+
+		template<typename T>
+		S72B::Section append(const T* data, size_t count) {
+			static_assert(std::is_trivially_copyable_v<T>, "cache sections must be trivially copyable");
+			uint64_t offset = (bytes.size() + S72B::SECTION_ALIGNMENT - 1) & ~(S72B::SECTION_ALIGNMENT - 1);
+			bytes.resize(offset + count * sizeof(T));
+			if (count) std::memcpy(bytes.data() + offset, data, count * sizeof(T));
+			return S72B::Section{ offset, count };
+		}
+
+		template<typename T>
+		S72B::Section append(const std::vector<T>& data) {
+			return append(data.data(), data.size());
+		}
+
+		template<typename T>
+		void appendComponents(S72B::Header& header, S72B::SectionType dataSection, S72B::SectionType idxsSection, const EnitityComponents<T>& components) {
+			header.sections[dataSection] = append(components.data());
+			std::vector<S72B::IdxEntry> idxs{};
+			idxs.reserve(components.idxs().size());
+			for (const auto& [id, idx] : components.idxs()) idxs.emplace_back(S72B::IdxEntry{ id, idx });
+			header.sections[idxsSection] = append(idxs);
+		}
+	};
+
+	//every read is bounds checked against the mapping, a truncated or corrupted cache is just treated as stale
+	struct CacheReader {
+		const MappedFile& file;
+		const S72B::Header& header;
+
+		template<typename T>
+		bool read(S72B::SectionType type, std::vector<T>& out) const {
+			static_assert(std::is_trivially_copyable_v<T>, "cache sections must be trivially copyable");
+			S72B::Section section = header.sections[type];
+			if (section.offset > file.size() || section.count > (file.size() - section.offset) / sizeof(T)) return false;
+			out.resize(section.count);
+			if (section.count) std::memcpy(out.data(), file.data() + section.offset, section.count * sizeof(T));
+			return true;
+		}
+
+		//entity ids are checked here so remapping them later can't go out of range
+		bool readIdxs(S72B::SectionType type, size_t dataSize, std::unordered_map<entitySize_t, uint32_t>& idxs) const {
+			std::vector<S72B::IdxEntry> entries{};
+			if (!read(type, entries)) return false;
+			idxs.reserve(entries.size());
+			for (const S72B::IdxEntry& entry : entries) {
+				if (entry.id - header.firstEntityID >= header.entityCount || entry.idx >= dataSize) return false;
+				idxs.insert({ entry.id, entry.idx });
+			}
+			return true;
+		}
+
+		template<typename T>
+		bool readComponents(S72B::SectionType dataSection, S72B::SectionType idxsSection, std::vector<T>& data, std::unordered_map<entitySize_t, uint32_t>& idxs) const {
+			return read(dataSection, data) && readIdxs(idxsSection, data.size(), idxs);
+		}
+
+		bool readString(S72B::StringRef ref, const std::vector<char>& strings, std::string& out) const {
+			if (ref.offset > strings.size() || ref.size > strings.size() - ref.offset) return false;
+			out.assign(strings.data() + ref.offset, ref.size);
+			return true;
+		}
+	};
+
+	template<typename T>
+	void restoreComponents(EnitityComponents<T>& components, std::vector<T>&& data, std::unordered_map<entitySize_t, uint32_t>&& idxs, entitySize_t idOffset) {
+		std::unordered_map<entitySize_t, uint32_t> rebased{};
+		rebased.reserve(idxs.size());
+		for (const auto& [id, idx] : idxs) rebased.insert({ id + idOffset, idx });
+		components.restore(std::move(data), std::move(rebased));
+	}
+}
+
+void Scene::saveCache(const std::string& scenePath, const ModeConstantParameters& parameters) {
+	static_assert(std::is_trivially_copyable_v<S72B::Header>);
+	static_assert(std::is_trivially_copyable_v<Mesh> && std::is_trivially_copyable_v<Meshlet> && std::is_trivially_copyable_v<Camera> && std::is_trivially_copyable_v<OrbitControl>);
+	static_assert(std::is_trivially_copyable_v<Material> && std::is_trivially_copyable_v<Light> && std::is_trivially_copyable_v<Environment>);
+
+	S72B::Header header{};
+	header.vertexSize = sizeof(Vertex);
+	header.indexSize = sizeof(Index);
+	header.nodeSize = sizeof(NodeRecord);
+	header.meshSize = sizeof(Mesh);
+	header.debugView = parameters.ENABLE_DEBUG_VIEW;
+	header.meshOptions = meshOptions(parameters);
+	header.startCameraHash = S72B::hashBytes(parameters.START_CAMERA_NAME.data(), parameters.START_CAMERA_NAME.size());
+
+	//ids of the scene's entities, all references below point into this range
+	entitySize_t firstID = NO_ENTITY, lastID = 0;
+	for (const auto& [id, idx] : graph.idxs()) {
+		firstID = std::min(firstID, id);
+		lastID = std::max(lastID, id);
+	}
+	if (firstID == NO_ENTITY) return;
+	header.firstEntityID = firstID;
+	header.entityCount = lastID - firstID + 1;
+	header.rootID = rootID;
+	header.renderCameraID = renderCameraID;
+	header.cullingCameraID = cullingCameraID;
+	header.sharedDebugIndexOffset = Mesh::sharedDebugIndexOffset;
+	header.sharedDebugVertexOffset = Mesh::sharedDebugVertexOffset;
+
+	CacheWriter writer{};
+	writer.bytes.resize(sizeof(S72B::Header));
+
+	std::vector<char> strings{};
+	auto addString = [&](const std::string& str) {
+		S72B::StringRef ref{ strings.size(), str.size() };
+		strings.insert(strings.end(), str.begin(), str.end());
+		return ref;
+	};
+	header.fileVersion = addString(fileVersion);
+
+	std::sort(tempSourceFiles.begin(), tempSourceFiles.end());
+	tempSourceFiles.erase(std::unique(tempSourceFiles.begin(), tempSourceFiles.end()), tempSourceFiles.end());
+	std::vector<S72B::Source> sources{};
+	sources.reserve(tempSourceFiles.size());
+	for (const std::string& path : tempSourceFiles) {
+		S72B::Source source{};
+		source.path = addString(path);
+		if (!sourceStat(path, source.size, source.writeTime) || !sourceHash(path, source.hash)) {
+			std::cerr << "Scene cache not written, could not read source " << path << std::endl;
+			return;
+		}
+		sources.emplace_back(source);
+	}
+	header.sections[S72B::STRINGS] = writer.append(strings);
+	header.sections[S72B::SOURCES] = writer.append(sources);
+
+	std::vector<NodeRecord> nodes{};
+	nodes.reserve(graph.data().size());
+	for (const SceneNode& node : graph.data()) {
+		nodes.emplace_back(NodeRecord{ node.transform, node.entity.getID(), node.entity.getFlags(), node.sibling, node.child, node.parent });
+	}
+	header.sections[S72B::NODES] = writer.append(nodes);
+	std::vector<S72B::IdxEntry> nodeIdxs{};
+	nodeIdxs.reserve(graph.idxs().size());
+	for (const auto& [id, idx] : graph.idxs()) nodeIdxs.emplace_back(S72B::IdxEntry{ id, idx });
+	header.sections[S72B::NODE_IDXS] = writer.append(nodeIdxs);
+
+	writer.appendComponents(header, S72B::MESHES, S72B::MESH_IDXS, meshes);
+	writer.appendComponents(header, S72B::MATERIALS, S72B::MATERIAL_IDXS, materials);
+	writer.appendComponents(header, S72B::CAMERAS, S72B::CAMERA_IDXS, cameras);
+	writer.appendComponents(header, S72B::ORBIT_CONTROLS, S72B::ORBIT_CONTROL_IDXS, orbitControls);
+	writer.appendComponents(header, S72B::LIGHTS, S72B::LIGHT_IDXS, lights);
+	writer.appendComponents(header, S72B::ENVIRONMENTS, S72B::ENVIRONMENT_IDXS, environments);
+
+	std::vector<S72B::DriverRecord> driverRecords{};
+	std::vector<float> driverFloats{};
+	driverRecords.reserve(drivers.data().size());
+	for (const Driver& driver : drivers.data()) {
+		S72B::DriverRecord record{};
+		record.entityID = driver.entityID;
+		record.flags = driverFlags(driver);
+		record.timesOffset = driverFloats.size();
+		record.timesCount = driver.times.size();
+		driverFloats.insert(driverFloats.end(), driver.times.begin(), driver.times.end());
+		record.valuesOffset = driverFloats.size();
+		record.valuesCount = driver.values.size();
+		driverFloats.insert(driverFloats.end(), driver.values.begin(), driver.values.end());
+		driverRecords.emplace_back(record);
+	}
+	header.sections[S72B::DRIVERS] = writer.append(driverRecords);
+	header.sections[S72B::DRIVER_FLOATS] = writer.append(driverFloats);
+	std::vector<S72B::IdxEntry> driverIdxs{};
+	for (const auto& [id, idx] : drivers.idxs()) driverIdxs.emplace_back(S72B::IdxEntry{ id, idx });
+	header.sections[S72B::DRIVER_IDXS] = writer.append(driverIdxs);
+
+	//everything this scene appended to the global buffers, meshes reference them by absolute offset
+	header.verticesBase = tempVerticesBase;
+	header.indicesBase = tempIndicesBase;
+	header.sections[S72B::VERTICES] = writer.append(vertices.data() + tempVerticesBase, vertices.size() - tempVerticesBase);
+	header.sections[S72B::INDICES] = writer.append(indices.data() + tempIndicesBase, indices.size() - tempIndicesBase);
+	header.sections[S72B::MESHLETS] = writer.append(meshlets);
+
+	std::memcpy(writer.bytes.data(), &header, sizeof(S72B::Header));
+
+	//written to a temporary then renamed over the old cache, so a crash mid-write never leaves a torn cache behind
+	std::string path = S72B::cachePath(scenePath);
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(writer.bytes.data(), writer.bytes.size());
+		if (!file.good()) {
+			std::cerr << "Scene cache not written, could not write " << tempPath << std::endl;
+			return;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (error) {
+		std::cerr << "Scene cache not written, could not replace " << path << " : " << error.message() << std::endl;
+		std::filesystem::remove(tempPath, error);
+	}
+}
+
+bool Scene::loadCache(const std::string& scenePath, const ModeConstantParameters& parameters) {
+	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
+	std::string path = S72B::cachePath(scenePath);
+	MappedFile file;
+	if (!file.open(path)) return false;
+
+	S72B::Header header{};
+	if (file.size() < sizeof(S72B::Header)) return false;
+	std::memcpy(&header, file.data(), sizeof(S72B::Header));
+	if (std::memcmp(header.magic, S72B::MAGIC, sizeof(S72B::MAGIC)) != 0 || header.version != S72B::VERSION) return false;
+	if (header.vertexSize != sizeof(Vertex) || header.indexSize != sizeof(Index) || header.nodeSize != sizeof(NodeRecord) || header.meshSize != sizeof(Mesh)) return false;
+	if (header.debugView != static_cast<uint32_t>(parameters.ENABLE_DEBUG_VIEW)) return false;
+	if (header.meshOptions != meshOptions(parameters)) return false;
+	if (header.startCameraHash != S72B::hashBytes(parameters.START_CAMERA_NAME.data(), parameters.START_CAMERA_NAME.size())) return false;
+	if (header.verticesBase != vertices.size() || header.indicesBase != indices.size()) return false;
+
+	CacheReader reader{ file, header };
+	std::vector<char> strings{};
+	std::vector<S72B::Source> sources{};
+	if (!reader.read(S72B::STRINGS, strings) || !reader.read(S72B::SOURCES, sources)) return false;
+	for (const S72B::Source& source : sources) {
+		std::string sourcePath;
+		if (!reader.readString(source.path, strings, sourcePath)) return false;
+		uint64_t size = 0;
+		int64_t writeTime = 0;
+		if (!sourceStat(sourcePath, size, writeTime) || size != source.size) return false;
+		if (writeTime == source.writeTime) continue;
+		uint64_t hash = 0;
+		if (!sourceHash(sourcePath, hash) || hash != source.hash) return false;
+	}
+
+	//everything is read into temporaries first, so a bad cache leaves the scene and the entity counters untouched
+	std::string cachedFileVersion;
+	if (!reader.readString(header.fileVersion, strings, cachedFileVersion)) return false;
+
+	std::vector<NodeRecord> nodes{};
+	std::unordered_map<entitySize_t, uint32_t> nodeIdxs{};
+	std::vector<Mesh> meshData{};
+	std::unordered_map<entitySize_t, uint32_t> meshIdxs{};
+	std::vector<Material> materialData{};
+	std::unordered_map<entitySize_t, uint32_t> materialIdxs{};
+	std::vector<Camera> cameraData{};
+	std::unordered_map<entitySize_t, uint32_t> cameraIdxs{};
+	std::vector<OrbitControl> orbitControlData{};
+	std::unordered_map<entitySize_t, uint32_t> orbitControlIdxs{};
+	std::vector<Light> lightData{};
+	std::unordered_map<entitySize_t, uint32_t> lightIdxs{};
+	std::vector<Environment> environmentData{};
+	std::unordered_map<entitySize_t, uint32_t> environmentIdxs{};
+	std::vector<S72B::DriverRecord> driverRecords{};
+	std::vector<float> driverFloats{};
+	std::unordered_map<entitySize_t, uint32_t> driverIdxs{};
+	std::vector<Meshlet> meshletData{};
+	if (!reader.read(S72B::NODES, nodes) || !reader.readIdxs(S72B::NODE_IDXS, nodes.size(), nodeIdxs)) return false;
+	if (!reader.readComponents(S72B::MESHES, S72B::MESH_IDXS, meshData, meshIdxs)) return false;
+	if (!reader.readComponents(S72B::MATERIALS, S72B::MATERIAL_IDXS, materialData, materialIdxs)) return false;
+	if (!reader.readComponents(S72B::CAMERAS, S72B::CAMERA_IDXS, cameraData, cameraIdxs)) return false;
+	if (!reader.readComponents(S72B::ORBIT_CONTROLS, S72B::ORBIT_CONTROL_IDXS, orbitControlData, orbitControlIdxs)) return false;
+	if (!reader.readComponents(S72B::LIGHTS, S72B::LIGHT_IDXS, lightData, lightIdxs)) return false;
+	if (!reader.readComponents(S72B::ENVIRONMENTS, S72B::ENVIRONMENT_IDXS, environmentData, environmentIdxs)) return false;
+	if (!reader.read(S72B::DRIVERS, driverRecords) || !reader.read(S72B::DRIVER_FLOATS, driverFloats)) return false;
+	if (!reader.readIdxs(S72B::DRIVER_IDXS, driverRecords.size(), driverIdxs)) return false;
+	if (!reader.read(S72B::MESHLETS, meshletData)) return false;
+
+	//every reference must be an id of this scene or NO_ENTITY
+	auto validID = [&](entitySize_t id, bool allowNone) {
+		return (allowNone && id == NO_ENTITY) || (id - header.firstEntityID < header.entityCount);
+	};
+	for (const NodeRecord& node : nodes) {
+		if (!validID(node.id, false) || !validID(node.sibling, true) || !validID(node.child, true) || !validID(node.parent, true)) return false;
+	}
+	for (const S72B::DriverRecord& record : driverRecords) {
+		if (!validID(record.entityID, false)) return false;
+		if (record.timesOffset > driverFloats.size() || record.timesCount > driverFloats.size() - record.timesOffset) return false;
+		if (record.valuesOffset > driverFloats.size() || record.valuesCount > driverFloats.size() - record.valuesOffset) return false;
+	}
+	if (!validID(header.rootID, true) || !validID(header.renderCameraID, true) || !validID(header.cullingCameraID, true)) return false;
+
+	S72B::Section vertexSection = header.sections[S72B::VERTICES];
+	S72B::Section indexSection = header.sections[S72B::INDICES];
+	if (vertexSection.offset > file.size() || vertexSection.count > (file.size() - vertexSection.offset) / sizeof(Vertex)) return false;
+	if (indexSection.offset > file.size() || indexSection.count > (file.size() - indexSection.offset) / sizeof(Index)) return false;
+	for (const Mesh& mesh : meshData) {
+		if (mesh.numLods > mesh.lods.size()) return false;
+		for (uint32_t lod = 0; lod < mesh.numLods; lod++) {
+			uint32_t lodStart = lod == 0 ? mesh.numIndices : mesh.lods[lod - 1].firstIndex + mesh.lods[lod - 1].numIndices;
+			if (mesh.lods[lod].firstIndex < lodStart || mesh.lods[lod].numIndices > std::numeric_limits<uint32_t>::max() - mesh.lods[lod].firstIndex) return false;
+		}
+		if (mesh.indexOffset < header.indicesBase || mesh.indexOffset - header.indicesBase + uint64_t(mesh.totalIndices()) > indexSection.count) return false;
+		if (mesh.vertexOffset < header.verticesBase || mesh.vertexOffset - header.verticesBase > vertexSection.count) return false;
+		if (mesh.meshletOffset > meshletData.size() || mesh.numMeshlets > meshletData.size() - mesh.meshletOffset) return false;
+		for (uint32_t meshletIdx = mesh.meshletOffset; meshletIdx < mesh.meshletOffset + mesh.numMeshlets; meshletIdx++) {
+			if (uint64_t(meshletData[meshletIdx].firstIndex) + meshletData[meshletIdx].numIndices > mesh.numIndices) return false;
+		}
+	}
+
+	//cache is good, rebase its ids onto a fresh range so they can't collide with entities created before this scene
+	entitySize_t idOffset = Entity::reserveIDs(header.entityCount) - header.firstEntityID;
+	auto rebase = [&](entitySize_t id) { return id == NO_ENTITY ? id : id + idOffset; };
+
+	fileVersion = std::move(cachedFileVersion);
+	rootID = rebase(header.rootID);
+	renderCameraID = rebase(header.renderCameraID);
+	cullingCameraID = rebase(header.cullingCameraID);
+	Mesh::sharedDebugIndexOffset = header.sharedDebugIndexOffset;
+	Mesh::sharedDebugVertexOffset = header.sharedDebugVertexOffset;
+
+	std::vector<SceneNode> graphData{};
+	graphData.reserve(nodes.size());
+	for (const NodeRecord& node : nodes) {
+		graphData.emplace_back(node.transform, Entity::restore(rebase(node.id), node.flags), rebase(node.sibling), rebase(node.child), rebase(node.parent));
+	}
+	restoreComponents(graph, std::move(graphData), std::move(nodeIdxs), idOffset);
+	restoreComponents(meshes, std::move(meshData), std::move(meshIdxs), idOffset);
+	meshlets = std::move(meshletData);
+	restoreComponents(materials, std::move(materialData), std::move(materialIdxs), idOffset);
+	restoreComponents(cameras, std::move(cameraData), std::move(cameraIdxs), idOffset);
+	restoreComponents(orbitControls, std::move(orbitControlData), std::move(orbitControlIdxs), idOffset);
+	restoreComponents(lights, std::move(lightData), std::move(lightIdxs), idOffset);
+	restoreComponents(environments, std::move(environmentData), std::move(environmentIdxs), idOffset);
+
+	std::vector<Driver> driverData(driverRecords.size());
+	for (size_t i = 0; i < driverRecords.size(); i++) {
+		const S72B::DriverRecord& record = driverRecords[i];
+		Driver& driver = driverData[i];
+		driver.entityID = rebase(record.entityID);
+		setDriverFlags(driver, record.flags);
+		driver.times.assign(driverFloats.begin() + record.timesOffset, driverFloats.begin() + record.timesOffset + record.timesCount);
+		driver.values.assign(driverFloats.begin() + record.valuesOffset, driverFloats.begin() + record.valuesOffset + record.valuesCount);
+	}
+	restoreComponents(drivers, std::move(driverData), std::move(driverIdxs), idOffset);
+
+	//the only copy of the geometry, straight out of the mapping into the global buffers
+	vertices.resize(vertices.size() + vertexSection.count);
+	if (vertexSection.count) std::memcpy(vertices.data() + header.verticesBase, file.data() + vertexSection.offset, vertexSection.count * sizeof(Vertex));
+	indices.resize(indices.size() + indexSection.count);
+	if (indexSection.count) std::memcpy(indices.data() + header.indicesBase, file.data() + indexSection.offset, indexSection.count * sizeof(Index));
+
+	if (CHECK_VALIDITY) assert(!sceneHasRoot() || graph.contains(rootID));
+	return true;
+}
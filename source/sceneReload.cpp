@@ -0,0 +1,326 @@
+#include "scene.hpp"
+#include "utils.hpp"
+#include <iostream>
+#include <algorithm>
+
+//everything updateHotReload needs to find the loaded objects again by name, the temp maps are gone after construction
+struct Scene::HotReload {
+	std::string scenePath;
+	FileWatcher watcher{};
+	//meshes that outgrow their range are moved to the end of the global buffers, which can't grow past these
+	uint32_t vertexLimit = 0;
+	uint32_t indexLimit = 0;
+
+	struct NodeState {
+		entitySize_t entityID = 0;
+		glm::vec3 translation{};
+		glm::quat rotation{};
+		glm::vec3 scale{};
+		//names the node refers to, a change means the graph itself changed
+		std::string references;
+	};
+	std::unordered_map<std::string, NodeState> nodes{};
+
+	struct MeshState {
+		uint32_t meshIdx = 0; //into meshes' _data
+		std::string geometryKey; //see Mesh::geometryKey
+		std::string material;
+		std::vector<std::string> files; //resolved, as reported by the watcher
+		//range the mesh was loaded into, a reloaded mesh is written back into it if it still fits
+		uint32_t firstVertex = 0;
+		uint32_t numVertices = 0;
+		uint32_t vertexCapacity = 0;
+		uint32_t indexCapacity = 0;
+	};
+	std::unordered_map<std::string, MeshState> meshes{};
+
+	std::unordered_map<std::string, uint32_t> cameras{}; //idx into cameras' _data
+	//node name of each driver, in file order, which is also the order of drivers' _data
+	std::vector<std::string> driverNodes{};
+	std::string roots;
+};
+
+namespace {
+	//the device buffers are created this much larger than the loaded scene, as room for meshes that grow
+	constexpr float HOT_RELOAD_HEADROOM = 0.5f;
+
+	void appendName(std::string& out, std::string_view name) {
+		out.append(name);
+		out.push_back('\0');
+	}
+
+	std::string nodeReferences(const S72Node& node) {
+		std::string references;
+		appendName(references, node.mesh);
+		appendName(references, node.camera);
+		appendName(references, node.environment);
+		appendName(references, node.light);
+		for (std::string_view child : node.children) appendName(references, child);
+		return references;
+	}
+
+	std::vector<std::string> meshFiles(const S72Mesh& mesh) {
+		std::vector<std::string> files{};
+		for (const S72Attribute& attribute : mesh.attributes) files.emplace_back(Mesh::findFile(std::string(attribute.src)));
+		if (S72_HAS(mesh, "indices")) files.emplace_back(Mesh::findFile(std::string(mesh.indices.src)));
+		std::sort(files.begin(), files.end());
+		files.erase(std::unique(files.begin(), files.end()), files.end());
+		return files;
+	}
+
+	std::string_view positionSource(const S72Mesh& mesh) {
+		for (const S72Attribute& attribute : mesh.attributes) {
+			if (S72::ATTRIBUTE_NAMES.find(attribute.name) == S72::POSITION) return attribute.src;
+		}
+		return {};
+	}
+
+	bool sameRotation(const glm::quat& a, const glm::quat& b) {
+		return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+	}
+
+	bool sameCamera(const Camera& a, const Camera& b) {
+		return a.aspect == b.aspect && a.vfov == b.vfov && a.nearPlane == b.nearPlane && a.farPlane == b.farPlane && a.type == b.type;
+	}
+
+	bool sameDriver(const Driver& a, const Driver& b) {
+		return a.times == b.times && a.values == b.values &&
+			a.isChannelTranslation() == b.isChannelTranslation() && a.isChannelScale() == b.isChannelScale() && a.isChannelRotation() == b.isChannelRotation() &&
+			a.isInterpolationStep() == b.isInterpolationStep() && a.isInterpolationLinear() == b.isInterpolationLinear() && a.isInterpolationSlerp() == b.isInterpolationSlerp();
+	}
+}
+
+void Scene::startHotReload(const std::string& scenePath, const std::vector<std::string_view>& rootNames, const ModeConstantParameters& parameters) {
+	const bool CHECK_VALIDITY = parameters.DEBUG && parameters.DEBUG_LEVEL >= 3;
+	std::shared_ptr<HotReload> reload = std::make_shared<HotReload>();
+	reload->scenePath = scenePath;
+	//patched meshes are rewritten into vertices / indices and uploaded from there
+	retainVertexIndexData = true;
+	for (std::string_view rootName : rootNames) appendName(reload->roots, rootName);
+
+	//only objects reachable from the roots were loaded, so only those have a component
+	for (const auto& [atom, node] : tempNodes) {
+		auto component = tempComponents.find(tmpComponentKey(NODE, atom));
+		if (component == tempComponents.end()) continue;
+		reload->nodes.emplace(std::string(tempAtoms.name(atom)), HotReload::NodeState{ static_cast<entitySize_t>(component->second),
+			node.data.translation, node.data.rotation, node.data.scale, nodeReferences(node.data) });
+	}
+	if (CHECK_VALIDITY) assert(tempMeshVertexRanges.size() == static_cast<size_t>(meshes.dataEnd() - meshes.dataBegin()));
+	for (const auto& [atom, mesh] : tempMeshes) {
+		auto component = tempComponents.find(tmpComponentKey(MESH, atom));
+		if (component == tempComponents.end()) continue;
+		uint32_t meshIdx = component->second;
+		const BufferRange& range = tempMeshVertexRanges[meshIdx];
+		reload->meshes.emplace(std::string(tempAtoms.name(atom)), HotReload::MeshState{ meshIdx, Mesh::geometryKey(mesh.data), std::string(mesh.data.material),
+			meshFiles(mesh.data), range.first, range.count, range.count, (meshes.dataBegin() + meshIdx)->totalIndices() });
+	}
+	for (const auto& [atom, camera] : tempCameras) {
+		auto component = tempComponents.find(tmpComponentKey(CAMERA, atom));
+		if (component != tempComponents.end()) reload->cameras.emplace(std::string(tempAtoms.name(atom)), component->second);
+	}
+	for (const auto& [nodeAtom, driver] : tempDrivers) reload->driverNodes.emplace_back(tempAtoms.name(nodeAtom));
+
+	std::vector<std::string> files = tempSourceFiles;
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+	reload->watcher.watch(files);
+
+	reload->vertexLimit = static_cast<uint32_t>(vertices.size() + static_cast<size_t>(vertices.size() * HOT_RELOAD_HEADROOM));
+	reload->indexLimit = static_cast<uint32_t>(indices.size() + static_cast<size_t>(indices.size() * HOT_RELOAD_HEADROOM));
+	//indices are local to each mesh's vertexOffset, so only a single mesh's vertices are limited by Index (see Mesh::loadMeshData)
+	reservedVertices = std::max(reservedVertices, reload->vertexLimit);
+	reservedIndices = std::max(reservedIndices, reload->indexLimit);
+	hotReload = std::move(reload);
+}
+
+bool Scene::updateHotReload(const ModeConstantParameters& parameters) {
+	if (!hotReload) return false;
+	HotReload& reload = *hotReload;
+	std::vector<std::string> changedFiles{};
+	if (!reload.watcher.poll(changedFiles)) return false;
+
+	//errors thrown while reading it are reported and the loaded scene is kept until the next write
+	JSONParser parser;
+	std::vector<std::string_view> rootNames{};
+	bool hasRoots = false;
+	try {
+		bool fileExists = false;
+		parser = JSONParser(reload.scenePath, &fileExists);
+		if (!fileExists) throw std::runtime_error("Failed to open " + reload.scenePath + "!");
+		parseObjects(parser, rootNames, hasRoots, parameters);
+	}
+	catch (const std::exception& error) {
+		std::cerr << "hot reload of " << reload.scenePath << " failed, keeping the loaded scene : " << error.what() << std::endl;
+		clearTempObjects();
+		return false;
+	}
+
+	uint32_t numStructural = 0;
+	uint32_t numTransforms = 0;
+	uint32_t numCameras = 0;
+	uint32_t numDrivers = 0;
+	uint32_t numMeshes = 0;
+
+	std::string roots;
+	for (std::string_view rootName : rootNames) appendName(roots, rootName);
+	if (roots != reload.roots) numStructural++;
+
+	//NODES, transforms are compared against the last parsed values since drivers move nodes at runtime
+	for (auto& [name, state] : reload.nodes) {
+		auto node = tempNodes.find(tempAtoms.find(name));
+		if (node == tempNodes.end()) {
+			numStructural++;
+			continue;
+		}
+		const S72Node& nodeData = node->second.data;
+		if (nodeReferences(nodeData) != state.references) numStructural++;
+		if (nodeData.translation == state.translation && sameRotation(nodeData.rotation, state.rotation) && nodeData.scale == state.scale) continue;
+		Transform& transform = graph.get(state.entityID).transform;
+		transform.translation = nodeData.translation;
+		transform.rotation = nodeData.rotation;
+		transform.scale = nodeData.scale;
+		state.translation = nodeData.translation;
+		state.rotation = nodeData.rotation;
+		state.scale = nodeData.scale;
+		numTransforms++;
+	}
+
+	//CAMERAS
+	for (const auto& [name, cameraIdx] : reload.cameras) {
+		auto camera = tempCameras.find(tempAtoms.find(name));
+		if (camera == tempCameras.end()) {
+			numStructural++;
+			continue;
+		}
+		Camera reloaded = initCamera(camera->second, parameters);
+		Camera& live = *(cameras.dataBegin() + cameraIdx);
+		if (sameCamera(live, reloaded)) continue;
+		live = reloaded;
+		numCameras++;
+	}
+
+	//DRIVERS, matched by position since they have no names of their own
+	bool sameDriverNodes = tempDrivers.size() == reload.driverNodes.size();
+	for (size_t i = 0; sameDriverNodes && i < tempDrivers.size(); i++) sameDriverNodes = tempAtoms.name(tempDrivers[i].first) == reload.driverNodes[i];
+	if (!sameDriverNodes) numStructural++;
+	else {
+		for (size_t i = 0; i < tempDrivers.size(); i++) {
+			Driver& live = *(drivers.dataBegin() + i);
+			Driver& reloaded = tempDrivers[i].second;
+			if (sameDriver(live, reloaded)) continue;
+			reloaded.entityID = live.entityID;
+			live = std::move(reloaded);
+			numDrivers++;
+		}
+	}
+
+	//MESHES, only ones whose geometry key or files changed are read again
+	struct MeshReload {
+		HotReload::MeshState* state;
+		const S72Mesh* s72Mesh;
+		Mesh mesh;
+		MeshStaging staging;
+	};
+	std::vector<MeshReload> meshReloads{};
+	for (auto& [name, state] : reload.meshes) {
+		auto mesh = tempMeshes.find(tempAtoms.find(name));
+		if (mesh == tempMeshes.end()) {
+			numStructural++;
+			continue;
+		}
+		const S72Mesh& s72Mesh = mesh->second.data;
+		if (s72Mesh.material != state.material) numStructural++;
+		std::string geometryKey = Mesh::geometryKey(s72Mesh);
+		bool filesChanged = std::any_of(state.files.begin(), state.files.end(), [&](const std::string& file) {
+			return std::find(changedFiles.begin(), changedFiles.end(), file) != changedFiles.end();
+			});
+		if (!filesChanged && geometryKey == state.geometryKey) continue;
+		state.geometryKey = std::move(geometryKey);
+		state.files = meshFiles(s72Mesh);
+		meshReloads.push_back(MeshReload{ &state, &s72Mesh, Mesh(), MeshStaging() });
+	}
+	try {
+		parallelFor(meshReloads.size(), resolveThreadCount(parameters.LOAD_THREADS), [&](size_t reloadIdx) {
+			MeshReload& meshReload = meshReloads[reloadIdx];
+			meshReload.mesh.loadMeshData(std::string(positionSource(*meshReload.s72Mesh)), *meshReload.s72Mesh, parameters, meshReload.staging);
+			});
+	}
+	catch (const std::exception& error) {
+		std::cerr << "hot reload failed to read a mesh, keeping the loaded meshes : " << error.what() << std::endl;
+		meshReloads.clear();
+	}
+	for (MeshReload& meshReload : meshReloads) {
+		HotReload::MeshState& state = *meshReload.state;
+		Mesh& live = *(meshes.dataBegin() + state.meshIdx);
+		const std::vector<Vertex>& newVertices = meshReload.staging.vertices;
+		const std::vector<Index>& newIndices = meshReload.staging.indices;
+		bool inPlace = true;
+		if (newVertices.size() > state.vertexCapacity || newIndices.size() > state.indexCapacity) {
+			if (vertices.size() + newVertices.size() > reload.vertexLimit || indices.size() + newIndices.size() > reload.indexLimit) {
+				std::cerr << "mesh " << meshReload.s72Mesh->name << " grew past the room left in the vertex / index buffers, restart to see it" << std::endl;
+				continue;
+			}
+			//the old range is abandoned, the mesh moves to the end of the buffers with its new size as capacity
+			state.firstVertex = static_cast<uint32_t>(vertices.size());
+			state.numVertices = 0;
+			state.vertexCapacity = static_cast<uint32_t>(newVertices.size());
+			state.indexCapacity = static_cast<uint32_t>(newIndices.size());
+			live.indexOffset = static_cast<uint32_t>(indices.size());
+			live.numIndices = 0;
+			live.numLods = 0;
+			vertices.resize(vertices.size() + newVertices.size());
+			indices.resize(indices.size() + newIndices.size());
+			inPlace = false;
+		}
+		//the file may have been written without this mesh's bytes changing
+		bool sameData = newVertices.size() == state.numVertices && newIndices.size() == live.totalIndices() &&
+			std::equal(newVertices.begin(), newVertices.end(), vertices.begin() + state.firstVertex);
+		sameData = sameData && std::equal(newIndices.begin(), newIndices.end(), indices.begin() + live.indexOffset);
+		if (sameData) continue;
+
+		std::copy(newVertices.begin(), newVertices.end(), vertices.begin() + state.firstVertex);
+		std::copy(newIndices.begin(), newIndices.end(), indices.begin() + live.indexOffset);
+		live.vertexOffset = state.firstVertex;
+		dirtyRangesInUse |= inPlace;
+		if (!newVertices.empty()) dirtyVertexRanges.emplace_back(BufferRange{ state.firstVertex, static_cast<uint32_t>(newVertices.size()) });
+		if (!newIndices.empty()) dirtyIndexRanges.emplace_back(BufferRange{ live.indexOffset, static_cast<uint32_t>(newIndices.size()) });
+		state.numVertices = static_cast<uint32_t>(newVertices.size());
+		live.numIndices = meshReload.mesh.numIndices;
+		live.lods = meshReload.mesh.lods;
+		live.numLods = meshReload.mesh.numLods;
+		live.bounds = meshReload.mesh.bounds;
+		live.boundingSphere = meshReload.mesh.boundingSphere;
+		live.orientedBounds = meshReload.mesh.orientedBounds;
+		if (parameters.CLUSTER) {
+			//meshlets only live on the CPU, so a mesh with more than before just moves them to the end of meshlets
+			const std::vector<Meshlet>& newMeshlets = meshReload.staging.meshlets;
+			if (newMeshlets.size() > live.numMeshlets) appendMeshlets(live, newMeshlets);
+			else {
+				std::copy(newMeshlets.begin(), newMeshlets.end(), meshlets.begin() + live.meshletOffset);
+				live.numMeshlets = static_cast<uint32_t>(newMeshlets.size());
+			}
+		}
+		if (parameters.ENABLE_DEBUG_VIEW) {
+			//rebuild the bounds cube in place, addDebugBounds would otherwise give it a new offset
+			uint32_t debugVertexOffset = live.debugVertexOffset;
+			addDebugBounds(live, meshReload.s72Mesh->name, parameters);
+			live.debugVertexOffset = debugVertexOffset;
+			uint32_t firstDebugVertex = Mesh::sharedDebugVertexOffset + debugVertexOffset;
+			std::copy(tempDebugVertices.begin(), tempDebugVertices.end(), vertices.begin() + firstDebugVertex);
+			dirtyVertexRanges.emplace_back(BufferRange{ firstDebugVertex, static_cast<uint32_t>(tempDebugVertices.size()) });
+			dirtyRangesInUse = true;
+			tempDebugVertices.clear();
+		}
+		numMeshes++;
+	}
+	clearTempObjects();
+
+	if (numStructural > 0) {
+		std::cerr << "hot reload : " << numStructural << " added, removed or re-referenced objects can't be patched in place, restart to see them" << std::endl;
+	}
+	uint32_t numPatched = numTransforms + numCameras + numDrivers + numMeshes;
+	if (numPatched > 0) {
+		std::cout << "hot reload : patched " << numTransforms << " transforms, " << numCameras << " cameras, " << numDrivers << " drivers and " << numMeshes << " meshes" << std::endl;
+	}
+	return numPatched > 0;
+}
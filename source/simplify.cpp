@@ -0,0 +1,184 @@
+#include "simplify.hpp"
+#include "vertexCache.hpp"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace {
+	//area weighted sum of squared distances to a set of planes n.p + offset = 0, as the symmetric matrix of the
+	//normals' outer products, the normals times their offsets and the squared offsets
+	struct Quadric {
+		double xx = 0.0, xy = 0.0, xz = 0.0, yy = 0.0, yz = 0.0, zz = 0.0;
+		double x = 0.0, y = 0.0, z = 0.0, dd = 0.0;
+		double weight = 0.0;
+
+		void addPlane(glm::vec3 normal, float offset, double w) {
+			const double nx = normal.x, ny = normal.y, nz = normal.z, d = offset;
+			xx += w * nx * nx; xy += w * nx * ny; xz += w * nx * nz;
+			yy += w * ny * ny; yz += w * ny * nz; zz += w * nz * nz;
+			x += w * nx * d; y += w * ny * d; z += w * nz * d;
+			dd += w * d * d;
+			weight += w;
+		}
+
+		Quadric& operator+=(const Quadric& other) {
+			xx += other.xx; xy += other.xy; xz += other.xz; yy += other.yy; yz += other.yz; zz += other.zz;
+			x += other.x; y += other.y; z += other.z; dd += other.dd;
+			weight += other.weight;
+			return *this;
+		}
+
+		//root mean squared distance from p to the planes
+		double distance(glm::vec3 p) const {
+			if (!(weight > 0.0)) return 0.0;
+			const double px = p.x, py = p.y, pz = p.z;
+			double error = xx * px * px + yy * py * py + zz * pz * pz + 2.0 * (xy * px * py + xz * px * pz + yz * py * pz)
+				+ 2.0 * (x * px + y * py + z * pz) + dd;
+			return std::sqrt(std::max(error, 0.0) / weight);
+		}
+	};
+
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double error;
+	};
+
+	bool degenerate(const Index* corners) {
+		return corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2];
+	}
+}
+
+uint32_t simplifyMesh(const Vertex* vertices, uint32_t numVertices, const Index* indices, uint32_t numIndices, uint32_t targetIndices, float maxError,
+	Index* out, float* errorOut) {
+	std::vector<Index> current;
+	current.reserve(numIndices / 3 * 3);
+	for (uint32_t i = 0; i + 3 <= numIndices; i += 3) {
+		if (!degenerate(indices + i)) current.insert(current.end(), indices + i, indices + i + 3);
+	}
+
+	std::vector<Quadric> quadrics(numVertices);
+	for (size_t i = 0; i < current.size(); i += 3) {
+		glm::vec3 a = vertices[current[i]].position, b = vertices[current[i + 1]].position, c = vertices[current[i + 2]].position;
+		glm::vec3 cross = glm::cross(b - a, c - a);
+		float length = glm::length(cross);
+		if (!(length > 0.0f)) continue;
+		glm::vec3 normal = cross / length;
+		Quadric plane{};
+		plane.addPlane(normal, -glm::dot(normal, a), 0.5 * length);
+		for (uint32_t corner = 0; corner < 3; corner++) quadrics[current[i + corner]] += plane;
+	}
+
+	//seams, vertices sharing a position with another vertex
+	std::vector<bool> locked(numVertices, false);
+	std::vector<uint32_t> byPosition(numVertices);
+	std::iota(byPosition.begin(), byPosition.end(), 0);
+	auto positionLess = [&](uint32_t a, uint32_t b) {
+		glm::vec3 pa = vertices[a].position, pb = vertices[b].position;
+		if (pa.x != pb.x) return pa.x < pb.x;
+		if (pa.y != pb.y) return pa.y < pb.y;
+		return pa.z < pb.z;
+	};
+	std::sort(byPosition.begin(), byPosition.end(), positionLess);
+	for (uint32_t i = 1; i < numVertices; i++) {
+		if (positionLess(byPosition[i - 1], byPosition[i])) continue;
+		locked[byPosition[i - 1]] = true;
+		locked[byPosition[i]] = true;
+	}
+	//borders and non manifold edges, any edge not shared by exactly two triangles
+	std::vector<uint64_t> edges;
+	edges.reserve(current.size());
+	for (size_t i = 0; i < current.size(); i += 3) {
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			uint64_t a = current[i + corner], b = current[i + (corner + 1) % 3];
+			edges.emplace_back(a < b ? (a << 32) | b : (b << 32) | a);
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t first = 0, last = 0; first < edges.size(); first = last) {
+		while (last < edges.size() && edges[last] == edges[first]) last++;
+		if (last - first == 2) continue;
+		locked[edges[first] >> 32] = true;
+		locked[edges[first] & 0xFFFFFFFF] = true;
+	}
+
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(numVertices);
+	std::iota(remap.begin(), remap.end(), 0);
+	//vertices a collapse this pass moved or whose triangles it changed, so every flip test sees the triangles as they are
+	std::vector<uint32_t> touchedPass(numVertices, 0);
+	uint32_t pass = 0;
+	double largestError = 0.0;
+	size_t numTriangles = current.size() / 3;
+
+	while (numTriangles * 3 > targetIndices) {
+		pass++;
+		VertexTriangles adjacency(current.data(), static_cast<uint32_t>(current.size()), numVertices);
+
+		//every interior edge is in two triangles, once each way, so a < b picks it once
+		collapses.clear();
+		for (size_t i = 0; i < current.size(); i += 3) {
+			for (uint32_t corner = 0; corner < 3; corner++) {
+				const uint32_t a = current[i + corner], b = current[i + (corner + 1) % 3];
+				if (a > b || (locked[a] && locked[b])) continue;
+				Quadric merged = quadrics[a];
+				merged += quadrics[b];
+				const double toB = locked[a] ? INFINITY : merged.distance(vertices[b].position);
+				const double toA = locked[b] ? INFINITY : merged.distance(vertices[a].position);
+				if (toB <= toA) collapses.push_back({ a, b, toB });
+				else collapses.push_back({ b, a, toA });
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.error < r.error; });
+
+		//a collapse that turns any triangle it keeps over is skipped
+		auto flips = [&](uint32_t from, uint32_t to) {
+			for (uint32_t adjacent = adjacency.offsets[from]; adjacent < adjacency.offsets[from + 1]; adjacent++) {
+				const Index* corners = current.data() + adjacency.triangles[adjacent] * 3;
+				if (corners[0] == to || corners[1] == to || corners[2] == to) continue;
+				glm::vec3 p[3] = { vertices[corners[0]].position, vertices[corners[1]].position, vertices[corners[2]].position };
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					if (corners[corner] == from) p[corner] = vertices[to].position;
+				}
+				glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+				if (!(glm::dot(before, after) > 0.0f)) return true;
+			}
+			return false;
+		};
+
+		size_t collapsed = 0;
+		for (const Collapse& collapse : collapses) {
+			if (collapse.error > maxError || numTriangles * 3 <= targetIndices) break;
+			if (touchedPass[collapse.from] == pass || touchedPass[collapse.to] == pass) continue;
+			if (flips(collapse.from, collapse.to)) continue;
+
+			for (uint32_t adjacent = adjacency.offsets[collapse.from]; adjacent < adjacency.offsets[collapse.from + 1]; adjacent++) {
+				const Index* corners = current.data() + adjacency.triangles[adjacent] * 3;
+				if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to) numTriangles--;
+				for (uint32_t corner = 0; corner < 3; corner++) touchedPass[corners[corner]] = pass;
+			}
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+			largestError = std::max(largestError, collapse.error);
+			collapsed++;
+		}
+		if (collapsed == 0) break;
+
+		//a collapse's target is never moved in the same pass, so one lookup is enough
+		size_t kept = 0;
+		for (size_t i = 0; i < current.size(); i += 3) {
+			Index corners[3] = { static_cast<Index>(remap[current[i]]), static_cast<Index>(remap[current[i + 1]]), static_cast<Index>(remap[current[i + 2]]) };
+			if (degenerate(corners)) continue;
+			std::copy(corners, corners + 3, current.begin() + kept);
+			kept += 3;
+		}
+		current.resize(kept);
+		numTriangles = kept / 3;
+		for (size_t i = 0; i < current.size(); i++) remap[current[i]] = current[i];
+	}
+
+	std::copy(current.begin(), current.end(), out);
+	if (errorOut) *errorOut = static_cast<float>(largestError);
+	return static_cast<uint32_t>(current.size());
+}
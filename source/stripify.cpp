@@ -0,0 +1,115 @@
+#include "stripify.hpp"
+#include "vertexCache.hpp"
+#include <limits>
+#include <algorithm>
+
+namespace {
+	constexpr uint32_t NO_TRIANGLE = std::numeric_limits<uint32_t>::max();
+
+	struct StripBuilder {
+		const Index* indices;
+		VertexTriangles adjacency;
+		std::vector<bool> used;
+		//triangles taken by the strip being tried, stamped with the trial so they needn't be cleared between trials
+		std::vector<uint32_t> trialStamp;
+		uint32_t trial = 0;
+
+		StripBuilder(const Index* _indices, uint32_t numIndices, uint32_t numVertices) : indices(_indices), adjacency(_indices, numIndices, numVertices),
+			used(numIndices / 3, false), trialStamp(numIndices / 3, 0) {};
+
+		bool available(uint32_t triangle) const { return !used[triangle] && trialStamp[triangle] != trial; };
+
+		//(a, b, c) is the same triangle as triangle with the same winding
+		bool sameWinding(uint32_t triangle, Index a, Index b, Index c) const {
+			const Index* corners = indices + triangle * 3;
+			for (uint32_t rotation = 0; rotation < 3; rotation++) {
+				if (corners[rotation] == a && corners[(rotation + 1) % 3] == b && corners[(rotation + 2) % 3] == c) return true;
+			}
+			return false;
+		}
+
+		//unused triangle across edge (a, b) that the strip can take next, and its third vertex
+		uint32_t nextTriangle(Index a, Index b, bool oddTriangle, Index& third) const {
+			for (uint32_t adjacent = adjacency.offsets[b]; adjacent < adjacency.offsets[b + 1]; adjacent++) {
+				const uint32_t triangle = adjacency.triangles[adjacent];
+				if (!available(triangle)) continue;
+				const Index* corners = indices + triangle * 3;
+				if (corners[0] != a && corners[1] != a && corners[2] != a) continue;
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					const Index c = corners[corner];
+					if (c == a || c == b) continue;
+					//odd triangles of a strip are drawn with their first two vertices swapped
+					if (oddTriangle ? sameWinding(triangle, b, a, c) : sameWinding(triangle, a, b, c)) {
+						third = c;
+						return triangle;
+					}
+				}
+			}
+			return NO_TRIANGLE;
+		}
+
+		//grows a strip from start, first vertex corners[rotation]. if strip is given the strip is appended to it and its
+		//triangles are used up, otherwise its triangles are only counted
+		uint32_t grow(uint32_t start, uint32_t rotation, std::vector<Index>* strip) {
+			trial++;
+			const Index* corners = indices + start * 3;
+			Index a = corners[(rotation + 1) % 3], b = corners[(rotation + 2) % 3];
+			if (strip) strip->insert(strip->end(), { corners[rotation], a, b });
+			trialStamp[start] = trial;
+			if (strip) used[start] = true;
+			uint32_t numTriangles = 1;
+			for (Index c; ; numTriangles++) {
+				const uint32_t triangle = nextTriangle(a, b, numTriangles % 2 == 1, c);
+				if (triangle == NO_TRIANGLE) break;
+				trialStamp[triangle] = trial;
+				if (strip) {
+					strip->emplace_back(c);
+					used[triangle] = true;
+				}
+				a = b;
+				b = c;
+			}
+			return numTriangles;
+		}
+	};
+}
+
+StripifyStats stripify(const Index* indices, uint32_t numIndices, std::vector<Index>& strips) {
+	StripifyStats stats{};
+	stats.listIndices = numIndices;
+	strips.clear();
+	const uint32_t numTriangles = numIndices / 3;
+	if (numTriangles == 0) return stats;
+	strips.reserve(numIndices);
+
+	//vertices are renumbered densely first, so the adjacency is sized by the vertices used, meshlets are
+	//stripified one at a time out of much larger meshes
+	std::vector<Index> vertexIDs(indices, indices + numTriangles * 3);
+	std::sort(vertexIDs.begin(), vertexIDs.end());
+	vertexIDs.erase(std::unique(vertexIDs.begin(), vertexIDs.end()), vertexIDs.end());
+	std::vector<Index> local(numTriangles * 3);
+	for (uint32_t i = 0; i < numTriangles * 3; i++) {
+		local[i] = static_cast<Index>(std::lower_bound(vertexIDs.begin(), vertexIDs.end(), indices[i]) - vertexIDs.begin());
+	}
+
+	StripBuilder builder(local.data(), numTriangles * 3, static_cast<uint32_t>(vertexIDs.size()));
+	for (uint32_t start = 0; start < numTriangles; start++) {
+		if (builder.used[start]) continue;
+		uint32_t bestRotation = 0, bestLength = 0;
+		for (uint32_t rotation = 0; rotation < 3; rotation++) {
+			uint32_t length = builder.grow(start, rotation, nullptr);
+			if (length > bestLength) {
+				bestLength = length;
+				bestRotation = rotation;
+			}
+		}
+
+		if (stats.strips > 0) strips.emplace_back(PRIMITIVE_RESTART_IDX);
+		size_t stripBegin = strips.size();
+		builder.grow(start, bestRotation, &strips);
+		for (size_t i = stripBegin; i < strips.size(); i++) strips[i] = vertexIDs[strips[i]];
+		stats.strips++;
+	}
+	stats.stripIndices = strips.size();
+	return stats;
+}
@@ -2,6 +2,13 @@
 #include <fstream>
 #include <iostream>
 #include <filesystem> // For std::filesystem
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 std::vector<char> readFile(const std::string& filename) {
 	std::ifstream file(filename, std::ios::ate | std::ios::binary);
@@ -22,4 +29,359 @@ std::vector<char> readFile(const std::string& filename) {
 
 std::vector<char> readShader(const std::string& filename) {
 	return readFile("shaders/compiled/" + filename + ".spv");
-};
\ No newline at end of file
+};
+
+size_t resolveThreadCount(int requested) {
+	if (requested > 0) return static_cast<size_t>(requested);
+	//hardware_concurrency may return 0 if it can't tell
+	return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void parallelFor(size_t taskCount, size_t numThreads, const std::function<void(size_t)>& func) {
+	numThreads = std::min(numThreads, taskCount);
+	if (numThreads <= 1) {
+		for (size_t taskIdx = 0; taskIdx < taskCount; taskIdx++) func(taskIdx);
+		return;
+	}
+
+	std::atomic<size_t> nextTask = 0;
+	std::exception_ptr firstException = nullptr;
+	std::mutex exceptionMutex;
+	auto worker = [&]() {
+		for (size_t taskIdx = nextTask++; taskIdx < taskCount; taskIdx = nextTask++) {
+			try {
+				func(taskIdx);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(exceptionMutex);
+				if (!firstException) firstException = std::current_exception();
+			}
+		}
+	};
+
+	//calling thread does its share of the work too
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads - 1);
+	for (size_t t = 1; t < numThreads; t++) threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads) thread.join();
+
+	if (firstException) std::rethrow_exception(firstException);
+}
+
+namespace {
+	constexpr uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+	constexpr uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+	constexpr uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+	constexpr uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+	constexpr uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+	inline uint64_t rotateLeft(uint64_t value, int bits) {
+		return (value << bits) | (value >> (64 - bits));
+	}
+	//little endian, like every other binary read in the loader
+	inline uint64_t read64(const unsigned char* bytes) {
+		uint64_t value;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+	inline uint32_t read32(const unsigned char* bytes) {
+		uint32_t value;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+	inline uint64_t xxhRound(uint64_t accumulator, uint64_t input) {
+		accumulator += input * XXH_PRIME64_2;
+		return rotateLeft(accumulator, 31) * XXH_PRIME64_1;
+	}
+	inline uint64_t xxhMergeRound(uint64_t accumulator, uint64_t value) {
+		accumulator ^= xxhRound(0, value);
+		return accumulator * XXH_PRIME64_1 + XXH_PRIME64_4;
+	}
+}
+
+uint64_t hashXXH64(const void* data, size_t size, uint64_t seed) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	const unsigned char* end = bytes + size;
+	uint64_t hash;
+	if (size >= 32) {
+		//four independent lanes over 32 byte stripes
+		uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+		uint64_t v2 = seed + XXH_PRIME64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - XXH_PRIME64_1;
+		for (; end - bytes >= 32; bytes += 32) {
+			v1 = xxhRound(v1, read64(bytes));
+			v2 = xxhRound(v2, read64(bytes + 8));
+			v3 = xxhRound(v3, read64(bytes + 16));
+			v4 = xxhRound(v4, read64(bytes + 24));
+		}
+		hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+		hash = xxhMergeRound(hash, v1);
+		hash = xxhMergeRound(hash, v2);
+		hash = xxhMergeRound(hash, v3);
+		hash = xxhMergeRound(hash, v4);
+	}
+	else {
+		hash = seed + XXH_PRIME64_5;
+	}
+	hash += static_cast<uint64_t>(size);
+
+	for (; end - bytes >= 8; bytes += 8) {
+		hash ^= xxhRound(0, read64(bytes));
+		hash = rotateLeft(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+	}
+	if (end - bytes >= 4) {
+		hash ^= static_cast<uint64_t>(read32(bytes)) * XXH_PRIME64_1;
+		hash = rotateLeft(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		bytes += 4;
+	}
+	for (; bytes < end; bytes++) {
+		hash ^= static_cast<uint64_t>(*bytes) * XXH_PRIME64_5;
+		hash = rotateLeft(hash, 11) * XXH_PRIME64_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <cerrno>
+#endif
+
+atom_t AtomTable::intern(std::string_view name) {
+	auto [it, inserted] = _atoms.try_emplace(name, static_cast<atom_t>(_names.size()));
+	if (inserted) _names.push_back(name);
+	return it->second;
+}
+
+atom_t AtomTable::find(std::string_view name) const {
+	auto it = _atoms.find(name);
+	return it == _atoms.end() ? NO_ATOM : it->second;
+}
+
+void AtomTable::reserve(size_t count) {
+	_atoms.reserve(count);
+	_names.reserve(count);
+}
+
+void AtomTable::clear() {
+	_atoms.clear();
+	_names.clear();
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this == &other) return *this;
+	close();
+	//moving the vector keeps its heap buffer, so _data stays valid for the read fallback too
+	_buffer = std::move(other._buffer);
+	_data = other._data;
+	_size = other._size;
+	_mapped = other._mapped;
+#ifdef _WIN32
+	_fileHandle = other._fileHandle;
+	_mappingHandle = other._mappingHandle;
+	other._fileHandle = nullptr;
+	other._mappingHandle = nullptr;
+#endif
+	other._data = nullptr;
+	other._size = 0;
+	other._mapped = false;
+	return *this;
+}
+
+bool MappedFile::readFallback(const std::string& filename) {
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+	if (!file.is_open()) return false;
+
+	//pre-sized so the whole file is read with a single call
+	_buffer.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(_buffer.data(), _buffer.size());
+	file.close();
+
+	_data = _buffer.data();
+	_size = _buffer.size();
+	_mapped = false;
+	return true;
+}
+
+bool MappedFile::open(const std::string& filename) {
+	close();
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(fileHandle);
+		return readFallback(filename);
+	}
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* view = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (view == nullptr) {
+		if (mappingHandle) CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return readFallback(filename);
+	}
+
+	_fileHandle = fileHandle;
+	_mappingHandle = mappingHandle;
+	_data = static_cast<const char*>(view);
+	_size = static_cast<size_t>(fileSize.QuadPart);
+	_mapped = true;
+	return true;
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat fileStat {};
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		::close(fd);
+		return readFallback(filename);
+	}
+	void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	//mapping holds its own reference to the file
+	::close(fd);
+	if (view == MAP_FAILED) return readFallback(filename);
+
+	//parsers walk the file front to back, let the kernel read ahead aggressively
+	madvise(view, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+	_data = static_cast<const char*>(view);
+	_size = static_cast<size_t>(fileStat.st_size);
+	_mapped = true;
+	return true;
+#endif
+}
+
+void MappedFile::close() {
+	if (_mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(_data);
+		CloseHandle(static_cast<HANDLE>(_mappingHandle));
+		CloseHandle(static_cast<HANDLE>(_fileHandle));
+		_mappingHandle = nullptr;
+		_fileHandle = nullptr;
+#else
+		munmap(const_cast<char*>(_data), _size);
+#endif
+	}
+	_buffer.clear();
+	_buffer.shrink_to_fit();
+	_data = nullptr;
+	_size = 0;
+	_mapped = false;
+}
+
+//how often the polling fallback of FileWatcher stats its files
+static constexpr int64_t FILE_WATCH_POLL_MS = 250;
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+	if (_inotify >= 0) ::close(_inotify);
+#endif
+}
+
+void FileWatcher::stampAll() {
+	_stamps.resize(_paths.size());
+	for (size_t i = 0; i < _paths.size(); i++) {
+		std::error_code error;
+		uint64_t size = static_cast<uint64_t>(std::filesystem::file_size(_paths[i], error));
+		if (error) size = 0;
+		int64_t writeTime = static_cast<int64_t>(std::filesystem::last_write_time(_paths[i], error).time_since_epoch().count());
+		if (error) writeTime = 0;
+		_stamps[i] = { size, writeTime };
+	}
+}
+
+void FileWatcher::watch(const std::vector<std::string>& paths) {
+	_paths = paths;
+#ifdef __linux__
+	if (_inotify >= 0) ::close(_inotify);
+	_directoryWatches.clear();
+	_fileNames.clear();
+	_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	for (const std::string& path : _paths) {
+		std::filesystem::path fsPath(path);
+		std::string directory = fsPath.has_parent_path() ? fsPath.parent_path().string() : std::string(".");
+		_fileNames.emplace_back(fsPath.filename().string());
+		int watchDescriptor = _inotify >= 0 ? inotify_add_watch(_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) : -1;
+		if (watchDescriptor < 0 && _inotify >= 0) {
+			std::cerr << "inotify can't watch " << directory << ", polling for changes instead\n";
+			::close(_inotify);
+			_inotify = -1;
+		}
+		_directoryWatches.push_back(watchDescriptor);
+	}
+	if (_inotify >= 0) return;
+#endif
+	stampAll();
+	_pending.assign(_paths.size(), false);
+	_lastPoll = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool FileWatcher::poll(std::vector<std::string>& changed) {
+	size_t numChanged = changed.size();
+	auto report = [&](size_t pathIdx) {
+		if (std::find(changed.begin() + numChanged, changed.end(), _paths[pathIdx]) == changed.end()) changed.push_back(_paths[pathIdx]);
+	};
+#ifdef __linux__
+	if (_inotify >= 0) {
+		alignas(inotify_event) char buffer[4096];
+		while (true) {
+			ssize_t length = read(_inotify, buffer, sizeof(buffer));
+			if (length <= 0) break;
+			for (ssize_t offset = 0; offset < length;) {
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+				if (event->len == 0) continue;
+				for (size_t i = 0; i < _paths.size(); i++) {
+					if (_directoryWatches[i] == event->wd && _fileNames[i] == event->name) report(i);
+				}
+			}
+		}
+		return changed.size() > numChanged;
+	}
+#endif
+	int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	if (now - _lastPoll < FILE_WATCH_POLL_MS) return false;
+	_lastPoll = now;
+	std::vector<std::pair<uint64_t, int64_t>> previous = std::move(_stamps);
+	stampAll();
+	for (size_t i = 0; i < _paths.size(); i++) {
+		if (_stamps[i] != previous[i]) _pending[i] = true;
+		else if (_pending[i]) {
+			_pending[i] = false;
+			report(i);
+		}
+	}
+	return changed.size() > numChanged;
+}
@@ -0,0 +1,106 @@
+#include "vertexCache.hpp"
+#include <limits>
+#include <algorithm>
+
+namespace {
+	constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+}
+
+VertexCacheStats analyzeVertexCache(const Index* indices, uint32_t numIndices, uint32_t numVertices, uint32_t cacheSize) {
+	VertexCacheStats stats{};
+	stats.triangles = numIndices / 3;
+	stats.vertices = numVertices;
+	//a vertex is still in the FIFO if fewer than cacheSize misses happened since it was last loaded
+	std::vector<uint64_t> loadedAt(numVertices, std::numeric_limits<uint64_t>::max());
+	for (uint32_t i = 0; i < numIndices; i++) {
+		uint64_t& loaded = loadedAt[indices[i]];
+		if (loaded != std::numeric_limits<uint64_t>::max() && stats.transformed - loaded < cacheSize) continue;
+		loaded = stats.transformed++;
+	}
+	return stats;
+}
+
+void optimizeVertexCache(Index* indices, uint32_t numIndices, uint32_t numVertices, uint32_t cacheSize) {
+	const uint32_t numTriangles = numIndices / 3;
+	if (numTriangles == 0 || numVertices == 0) return;
+	VertexTriangles adjacency(indices, numTriangles * 3, numVertices);
+
+	//triangles not yet emitted that use each vertex
+	std::vector<uint32_t> live(numVertices);
+	for (uint32_t v = 0; v < numVertices; v++) live[v] = adjacency.count(v);
+	//time each vertex last entered the cache, a vertex is cached while time - cacheTime[v] < cacheSize
+	std::vector<uint32_t> cacheTime(numVertices, 0);
+	uint32_t time = cacheSize + 1;
+	std::vector<bool> emitted(numTriangles, false);
+	//vertices of recently emitted triangles, where to restart when the fan vertex has no live neighbours left
+	std::vector<uint32_t> deadEnd;
+	deadEnd.reserve(numTriangles * 3);
+	std::vector<uint32_t> candidates;
+	uint32_t scanCursor = 0;
+
+	std::vector<Index> output;
+	output.reserve(numTriangles * 3);
+
+	uint32_t fanVertex = 0;
+	while (fanVertex != NO_VERTEX) {
+		candidates.clear();
+		for (uint32_t adjacent = adjacency.offsets[fanVertex]; adjacent < adjacency.offsets[fanVertex + 1]; adjacent++) {
+			const uint32_t triangle = adjacency.triangles[adjacent];
+			if (emitted[triangle]) continue;
+			emitted[triangle] = true;
+			for (uint32_t corner = 0; corner < 3; corner++) {
+				const Index vertex = indices[triangle * 3 + corner];
+				output.emplace_back(vertex);
+				deadEnd.emplace_back(vertex);
+				candidates.emplace_back(vertex);
+				live[vertex]--;
+				if (time - cacheTime[vertex] > cacheSize) cacheTime[vertex] = time++;
+			}
+		}
+
+		//next fan is the candidate that will still be cached after its remaining triangles are emitted, preferring
+		//the one that entered the cache earliest, so its reuse isn't lost
+		fanVertex = NO_VERTEX;
+		int64_t bestPriority = -1;
+		for (uint32_t candidate : candidates) {
+			if (live[candidate] == 0) continue;
+			int64_t priority = 0;
+			if (time - cacheTime[candidate] + 2 * live[candidate] <= cacheSize) priority = time - cacheTime[candidate];
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				fanVertex = candidate;
+			}
+		}
+		if (fanVertex != NO_VERTEX) continue;
+
+		//dead end, back up through recently used vertices, then fall back to scanning the whole mesh in order
+		while (!deadEnd.empty() && fanVertex == NO_VERTEX) {
+			const uint32_t vertex = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[vertex] > 0) fanVertex = vertex;
+		}
+		while (scanCursor < numVertices && fanVertex == NO_VERTEX) {
+			if (live[scanCursor] > 0) fanVertex = scanCursor;
+			scanCursor++;
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+uint32_t optimizeVertexFetch(Vertex* vertices, uint32_t numVertices, Index* indices, uint32_t numIndices) {
+	std::vector<uint32_t> remap(numVertices, NO_VERTEX);
+	uint32_t numUsed = 0;
+	for (uint32_t i = 0; i < numIndices; i++) {
+		uint32_t& newIdx = remap[indices[i]];
+		if (newIdx == NO_VERTEX) newIdx = numUsed++;
+		indices[i] = static_cast<Index>(newIdx);
+	}
+
+	std::vector<Vertex> reordered(numUsed);
+	for (uint32_t v = 0; v < numVertices; v++) {
+		if (remap[v] != NO_VERTEX) reordered[remap[v]] = vertices[v];
+	}
+	std::copy(reordered.begin(), reordered.end(), vertices);
+	return numUsed;
+}
@@ -1,12 +1,25 @@
 #include "vertexIndex.hpp"
 #include "vulkanCore.hpp"
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
 
 std::vector<Vertex> vertices = {};
 std::vector<Index> indices = {};
 Index PRIMITIVE_RESTART_IDX = std::numeric_limits<Index>().max();
+uint32_t reservedVertices = 0;
+uint32_t reservedIndices = 0;
+std::vector<BufferRange> dirtyVertexRanges = {};
+std::vector<BufferRange> dirtyIndexRanges = {};
+bool dirtyRangesInUse = false;
+bool retainVertexIndexData = false;
 
+uint32_t activeVertexLayout = 0;
+bool splitVertexPositions = false;
+
+namespace {
 #if defined(SIMPLE_VERTEX) && SIMPLE_VERTEX
-std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions() {
+std::vector<VkVertexInputAttributeDescription> fullAttributeDescriptions() {
     std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
 
     attributeDescriptions[0].binding = 0;
@@ -24,8 +37,7 @@ std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions()
 #else
 //type definitions
 
-//TODO allow for different vertex types, ie a vertex with only position and texCoord for windows
-std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions() {
+std::vector<VkVertexInputAttributeDescription> fullAttributeDescriptions() {
     std::vector<VkVertexInputAttributeDescription> attributeDescriptions(5);
     //static_assert(sizeof(Vertex) == sizeof(float)*12 + sizeof(uint32_t), "Vertex not packed, really size " sizeof(Vertex) << "!");
     attributeDescriptions[0].binding = 0;
@@ -56,32 +68,184 @@ std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions()
     return attributeDescriptions;
 }
 
+//compact layout, see vertexLayouts
+struct CompactVertex {
+    int16_t position[4]; //xyz * 2^w
+    uint32_t normal; //octahedral snorm16x2
+    uint32_t tangent; //octahedral snorm16x2, y remapped to [0, 1] and signed by handedness
+    uint32_t texCoord; //half2
+    uint32_t color;
+};
+static_assert(sizeof(CompactVertex) == 24, "CompactVertex not packed");
+
+//unit vector to the [-1, 1] square, the lower hemisphere folded over the diagonals
+glm::vec2 octahedralEncode(glm::vec3 v) {
+    float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (!(l1 > 0.0f)) return glm::vec2(0.0f);
+    glm::vec2 p = glm::vec2(v.x, v.y) / l1;
+    if (v.z < 0.0f) {
+        glm::vec2 folded = 1.0f - glm::abs(glm::vec2(p.y, p.x));
+        p = glm::vec2(p.x >= 0.0f ? folded.x : -folded.x, p.y >= 0.0f ? folded.y : -folded.y);
+    }
+    return p;
+}
+
+void encodeCompact(const Vertex* src, uint32_t count, void* dst) {
+    CompactVertex* out = reinterpret_cast<CompactVertex*>(dst);
+    for (uint32_t v = 0; v < count; v++) {
+        const Vertex& vertex = src[v];
+        CompactVertex& compact = out[v];
+        //exponent so the largest component lands just under 2^15, rounding can still reach it so clamp
+        float largest = std::max({ std::abs(vertex.position.x), std::abs(vertex.position.y), std::abs(vertex.position.z) });
+        int exponent = 0;
+        if (largest > 0.0f) {
+            std::frexp(largest, &exponent);
+            exponent -= 15;
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            float q = std::round(std::ldexp(vertex.position[axis], -exponent));
+            compact.position[axis] = static_cast<int16_t>(std::clamp(q, -32767.0f, 32767.0f));
+        }
+        compact.position[3] = static_cast<int16_t>(exponent);
+
+        compact.normal = glm::packSnorm2x16(octahedralEncode(vertex.normal));
+        glm::vec2 tangent = octahedralEncode(glm::vec3(vertex.tangent));
+        //smallest step above zero keeps the sign of a tangent at y = -1
+        float tangentY = std::max(tangent.y * 0.5f + 0.5f, 1.0f / 32767.0f);
+        compact.tangent = glm::packSnorm2x16(glm::vec2(tangent.x, vertex.tangent.w < 0.0f ? -tangentY : tangentY));
+        compact.texCoord = glm::packHalf2x16(vertex.texCoord);
+        compact.color = vertex.color;
+    }
+}
+
+std::vector<VkVertexInputAttributeDescription> compactAttributeDescriptions() {
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(5);
+    attributeDescriptions[0] = { 0, 0, VK_FORMAT_R16G16B16A16_SINT, static_cast<uint32_t>(offsetof(CompactVertex, position)) };
+    attributeDescriptions[1] = { 1, 0, VK_FORMAT_R16G16_SNORM, static_cast<uint32_t>(offsetof(CompactVertex, normal)) };
+    attributeDescriptions[2] = { 2, 0, VK_FORMAT_R16G16_SNORM, static_cast<uint32_t>(offsetof(CompactVertex, tangent)) };
+    attributeDescriptions[3] = { 3, 0, VK_FORMAT_R16G16_SFLOAT, static_cast<uint32_t>(offsetof(CompactVertex, texCoord)) };
+    attributeDescriptions[4] = { 4, 0, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(offsetof(CompactVertex, color)) };
+    return attributeDescriptions;
+}
 #endif 
 
+void encodeFull(const Vertex* src, uint32_t count, void* dst) {
+    memcpy(dst, src, static_cast<size_t>(count) * sizeof(Vertex));
+}
 
-//functions likely to differ between programs
-VkVertexInputBindingDescription getVertexBindingDescription() {
-    VkVertexInputBindingDescription bindingDescription{};
+std::vector<VertexLayout>& layoutRegistry() {
+    static std::vector<VertexLayout> layouts = {
+        { "full", sizeof(Vertex), fullAttributeDescriptions(), encodeFull, sizeof(Vertex::position) },
+#if !(defined(SIMPLE_VERTEX) && SIMPLE_VERTEX)
+        { "compact", sizeof(CompactVertex), compactAttributeDescriptions(), encodeCompact, sizeof(CompactVertex::position) },
+#endif
+    };
+    return layouts;
+}
+}
+
+const std::vector<VertexLayout>& vertexLayouts() {
+    return layoutRegistry();
+}
+
+uint32_t registerVertexLayout(VertexLayout layout) {
+    if (layout.encode == nullptr || layout.stride == 0) throw std::runtime_error("Vertex layout " + layout.name + " needs an encode function and a stride!");
+    layoutRegistry().emplace_back(std::move(layout));
+    return static_cast<uint32_t>(layoutRegistry().size() - 1);
+}
+
+uint32_t findVertexLayout(const std::string& name) {
+    const std::vector<VertexLayout>& layouts = vertexLayouts();
+    for (uint32_t id = 0; id < layouts.size(); id++) {
+        if (layouts[id].name == name) return id;
+    }
+    throw std::runtime_error("No vertex layout named " + name + "!");
+}
+
+uint32_t vertexStreamCount() {
+    return splitVertexPositions ? 2 : 1;
+}
+
+uint32_t vertexStreamStride(uint32_t stream) {
+    const VertexLayout& layout = getVertexLayout();
+    if (!splitVertexPositions) return layout.stride;
+    return stream == 0 ? layout.positionSize : layout.stride - layout.positionSize;
+}
+
+VkDeviceSize vertexStreamOffset(uint32_t stream, uint32_t numVertices) {
+    return stream == 0 ? 0 : static_cast<VkDeviceSize>(numVertices) * vertexStreamStride(0);
+}
+
+void encodeVertexStream(const Vertex* src, uint32_t count, uint32_t stream, void* dst) {
+    const VertexLayout& layout = getVertexLayout();
+    if (!splitVertexPositions) {
+        layout.encode(src, count, dst);
+        return;
+    }
+    //encoded interleaved a batch at a time, then the stream's bytes of each vertex are copied out
+    constexpr uint32_t BATCH = 1024;
+    std::vector<char> interleaved(static_cast<size_t>(std::min(count, BATCH)) * layout.stride);
+    const uint32_t first = stream == 0 ? 0 : layout.positionSize;
+    const uint32_t size = vertexStreamStride(stream);
+    char* out = reinterpret_cast<char*>(dst);
+    for (uint32_t begin = 0; begin < count; begin += BATCH) {
+        const uint32_t batch = std::min(count - begin, BATCH);
+        layout.encode(src + begin, batch, interleaved.data());
+        for (uint32_t v = 0; v < batch; v++, out += size) {
+            memcpy(out, interleaved.data() + static_cast<size_t>(v) * layout.stride + first, size);
+        }
+    }
+}
+
+std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions(bool positionsOnly) {
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+    for (VkVertexInputAttributeDescription attribute : getVertexLayout().attributes) {
+        if (attribute.location == 0) {
+            attributeDescriptions.emplace_back(attribute);
+            continue;
+        }
+        if (positionsOnly) continue;
+        if (splitVertexPositions) {
+            attribute.binding = 1;
+            attribute.offset -= getVertexLayout().positionSize;
+        }
+        attributeDescriptions.emplace_back(attribute);
+    }
+    return attributeDescriptions;
+}
 
-    bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-    return bindingDescription;
+//functions likely to differ between programs
+std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions(bool positionsOnly) {
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions(positionsOnly ? 1 : vertexStreamCount());
+    for (uint32_t stream = 0; stream < bindingDescriptions.size(); stream++) {
+        bindingDescriptions[stream].binding = stream;
+        bindingDescriptions[stream].stride = vertexStreamStride(stream);
+        bindingDescriptions[stream].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    }
+    return bindingDescriptions;
 }
 
 //functions likely constant between program instantiations
 void vertexBufferSize(uint32_t* numElements, uint32_t* elementSize) {
-    *numElements = static_cast<uint32_t>(vertices.size());
-    *elementSize = sizeof(Vertex);
+    *numElements = std::max(static_cast<uint32_t>(vertices.size()), reservedVertices);
+    *elementSize = getVertexLayout().stride;
 }
 
 
 void indexBufferSize(uint32_t* numElements, uint32_t* elementSize) {
-    *numElements = indices.size();
+    *numElements = std::max(static_cast<uint32_t>(indices.size()), reservedIndices);
     *elementSize = sizeof(Index);
 }
 
+void releaseVertexIndexData() {
+    if (DEBUG) assert(dirtyVertexRanges.empty() && dirtyIndexRanges.empty());
+    reservedVertices = std::max(static_cast<uint32_t>(vertices.size()), reservedVertices);
+    reservedIndices = std::max(static_cast<uint32_t>(indices.size()), reservedIndices);
+    std::vector<Vertex>().swap(vertices);
+    std::vector<Index>().swap(indices);
+}
+
 #ifdef COMBINED_VERTEX_INDEX_BUFFER
 void App::createVertexIndexBuffer() {
     uint32_t numVertices, vertexSizeSize = 0;
@@ -98,8 +262,11 @@ void App::createVertexIndexBuffer() {
 
     void* data;
     mapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), static_cast<size_t>(vertexBufferSize));
-    memcpy(reinterpret_cast<char*>(data) + vertexBufferSize, indices.data(), static_cast<size_t>(indexBufferSize));
+    //buffers may be sized for more than has been loaded yet, the rest is filled by uploadDirtyVertexIndexRanges
+    for (uint32_t stream = 0; stream < vertexStreamCount(); stream++) {
+        encodeVertexStream(vertices.data(), static_cast<uint32_t>(vertices.size()), stream, reinterpret_cast<char*>(data) + vertexStreamOffset(stream, numVertices));
+    }
+    memcpy(reinterpret_cast<char*>(data) + vertexBufferSize, indices.data(), indices.size() * sizeof(Index));
     unmapMemory(device, stagingBufferMemory);
 
     createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexIndexBuffer, vertexIndexBufferMemory);
@@ -113,9 +280,11 @@ void App::createVertexIndexBuffer() {
  }
 
 void App::bindVertexIndexBuffer(VkCommandBuffer commandBuffer) {
-    VkBuffer vertexBuffers[] = { vertexIndexBuffer };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets); //TODO bind both vertex+index in one call
+    uint32_t numStreamVertices, streamVertexSize = 0;
+    vertexBufferSize(&numStreamVertices, &streamVertexSize);
+    VkBuffer vertexBuffers[] = { vertexIndexBuffer, vertexIndexBuffer };
+    VkDeviceSize offsets[] = { vertexStreamOffset(0, numStreamVertices), vertexStreamOffset(1, numStreamVertices) };
+    vkCmdBindVertexBuffers(commandBuffer, 0, vertexStreamCount(), vertexBuffers, offsets); //TODO bind both vertex+index in one call
 
     static uint32_t numIndices, indexSize = 0;
     indexBufferSize(&numIndices, &indexSize);
@@ -141,7 +310,10 @@ void App::createVertexBuffer() {
     //TODO compare to explicitly flushing memory (instead of using HOST_COHERENT bit?)
     void* data;
     vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
+    //buffer may be sized for more than has been loaded yet, the rest is filled by uploadDirtyVertexIndexRanges
+    for (uint32_t stream = 0; stream < vertexStreamCount(); stream++) {
+        encodeVertexStream(vertices.data(), static_cast<uint32_t>(vertices.size()), stream, reinterpret_cast<char*>(data) + vertexStreamOffset(stream, numElements));
+    }
     vkUnmapMemory(device, stagingBufferMemory);
 
     createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
@@ -163,7 +335,7 @@ void App::createIndexBuffer() {
 
     void* data;
     vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t)bufferSize);
+    memcpy(data, indices.data(), indices.size() * sizeof(Index));
     vkUnmapMemory(device, stagingBufferMemory);
 
     createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
@@ -175,9 +347,11 @@ void App::createIndexBuffer() {
 }
 
 void App::bindVertexBuffer(VkCommandBuffer commandBuffer) {
-    VkBuffer vertexBuffers[] = { vertexBuffer };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets); //TODO bind both vertex+index in one call
+    uint32_t numStreamVertices, streamVertexSize = 0;
+    vertexBufferSize(&numStreamVertices, &streamVertexSize);
+    VkBuffer vertexBuffers[] = { vertexBuffer, vertexBuffer };
+    VkDeviceSize offsets[] = { vertexStreamOffset(0, numStreamVertices), vertexStreamOffset(1, numStreamVertices) };
+    vkCmdBindVertexBuffers(commandBuffer, 0, vertexStreamCount(), vertexBuffers, offsets); //TODO bind both vertex+index in one call
 }
 
 void App::bindIndexBuffer(VkCommandBuffer commandBuffer) {
@@ -192,4 +366,75 @@ void App::bindIndexBuffer(VkCommandBuffer commandBuffer) {
 }
 #endif
 
+//packs every dirty range into one staging buffer and copies them into place with a single command buffer
+void App::uploadDirtyVertexIndexRanges() {
+    if (dirtyVertexRanges.empty() && dirtyIndexRanges.empty()) return;
+    uint32_t numVertices, vertexSize = 0;
+    vertexBufferSize(&numVertices, &vertexSize);
+    uint32_t numIndices, indexSize = 0;
+    indexBufferSize(&numIndices, &indexSize);
+
+    VkDeviceSize stagingSize = 0;
+    for (const BufferRange& range : dirtyVertexRanges) stagingSize += static_cast<VkDeviceSize>(range.count) * vertexSize;
+    for (const BufferRange& range : dirtyIndexRanges) stagingSize += static_cast<VkDeviceSize>(range.count) * indexSize;
+    if (stagingSize == 0) {
+        dirtyVertexRanges.clear();
+        dirtyIndexRanges.clear();
+        dirtyRangesInUse = false;
+        return;
+    }
 
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+    void* data;
+    vkMapMemory(device, stagingBufferMemory, 0, stagingSize, 0, &data);
+    std::vector<VkBufferCopy> vertexCopies{};
+    std::vector<VkBufferCopy> indexCopies{};
+    VkDeviceSize srcOffset = 0;
+    for (const BufferRange& range : dirtyVertexRanges) {
+        if (range.count == 0) continue;
+        if (DEBUG) assert(range.first + range.count <= numVertices);
+        for (uint32_t stream = 0; stream < vertexStreamCount(); stream++) {
+            const uint32_t streamStride = vertexStreamStride(stream);
+            VkDeviceSize size = static_cast<VkDeviceSize>(range.count) * streamStride;
+            encodeVertexStream(vertices.data() + range.first, range.count, stream, reinterpret_cast<char*>(data) + srcOffset);
+            vertexCopies.push_back({ srcOffset, vertexStreamOffset(stream, numVertices) + static_cast<VkDeviceSize>(range.first) * streamStride, size });
+            srcOffset += size;
+        }
+    }
+#if defined(COMBINED_VERTEX_INDEX_BUFFER) && COMBINED_VERTEX_INDEX_BUFFER
+    //indices live after the whole (reserved) vertex region
+    VkDeviceSize indexRegionOffset = static_cast<VkDeviceSize>(numVertices) * vertexSize;
+#else
+    VkDeviceSize indexRegionOffset = 0;
+#endif
+    for (const BufferRange& range : dirtyIndexRanges) {
+        if (range.count == 0) continue;
+        if (DEBUG) assert(range.first + range.count <= numIndices);
+        VkDeviceSize size = static_cast<VkDeviceSize>(range.count) * indexSize;
+        memcpy(reinterpret_cast<char*>(data) + srcOffset, indices.data() + range.first, static_cast<size_t>(size));
+        indexCopies.push_back({ srcOffset, indexRegionOffset + static_cast<VkDeviceSize>(range.first) * indexSize, size });
+        srcOffset += size;
+    }
+    vkUnmapMemory(device, stagingBufferMemory);
+
+    //frames still in flight may be reading ranges patched in place
+    if (dirtyRangesInUse) vkWaitForFences(device, static_cast<uint32_t>(inFlightFences.size()), inFlightFences.data(), VK_TRUE, UINT64_MAX);
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+#if defined(COMBINED_VERTEX_INDEX_BUFFER) && COMBINED_VERTEX_INDEX_BUFFER
+    vertexCopies.insert(vertexCopies.end(), indexCopies.begin(), indexCopies.end());
+    vkCmdCopyBuffer(commandBuffer, stagingBuffer, vertexIndexBuffer, static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+#else
+    if (!vertexCopies.empty()) vkCmdCopyBuffer(commandBuffer, stagingBuffer, vertexBuffer, static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+    if (!indexCopies.empty()) vkCmdCopyBuffer(commandBuffer, stagingBuffer, indexBuffer, static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+#endif
+    endSingleTimeCommands(commandBuffer);
+
+    vkDestroyBuffer(device, stagingBuffer, nullptr);
+    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    dirtyVertexRanges.clear();
+    dirtyIndexRanges.clear();
+    dirtyRangesInUse = false;
+}
@@ -0,0 +1,170 @@
+#include "vertexWeld.hpp"
+#include "utils.hpp"
+#include <cstring>
+#include <vector>
+#include <bit>
+#include <limits>
+#include <algorithm>
+
+#if !defined(VERTEX_WELD_FORCE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define VERTEX_WELD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+	constexpr uint32_t HASH_K1 = 0x9E3779B1U;
+	constexpr uint32_t HASH_K2 = 0x85EBCA77U;
+	constexpr int HASH_ROTATE = 27;
+	constexpr uint32_t NUM_CHUNKS = (sizeof(Vertex) + 15) / 16;
+
+	//murmur3 finalizer, the chunk fold below leaves the bits poorly mixed
+	inline uint64_t finalizeHash(uint64_t hash) {
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDULL;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	//vertex copied into whole 16 byte chunks, zero padded
+	struct VertexChunks {
+		alignas(16) uint8_t bytes[NUM_CHUNKS * 16];
+	};
+	inline void loadChunks(const Vertex& vertex, VertexChunks& chunks) {
+		if constexpr (sizeof(Vertex) % 16 != 0) std::memset(chunks.bytes + (NUM_CHUNKS - 1) * 16, 0, 16);
+		std::memcpy(chunks.bytes, &vertex, sizeof(Vertex));
+	}
+
+	//open-addressing table of the unique vertices seen so far, linear probing, never more than half full
+	//slots keep the top bits of the hash so most mismatches are rejected without touching the vertex
+	struct WeldTable {
+		static constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+		struct Slot {
+			uint32_t tag = 0;
+			uint32_t vertex = EMPTY;
+		};
+		std::vector<Slot> slots;
+		uint64_t mask = 0;
+
+		explicit WeldTable(uint32_t maxEntries) {
+			size_t capacity = std::bit_ceil(std::max<size_t>(16, static_cast<size_t>(maxEntries) * 2));
+			slots.resize(capacity);
+			mask = capacity - 1;
+		}
+
+		//returns the vertex already in the table that equals candidate, or inserts newVertex and returns it
+		//vertexAt(i) returns the vertex an entry i refers to
+		template<typename VertexAt>
+		uint32_t findOrInsert(uint64_t hash, const Vertex& candidate, uint32_t newVertex, VertexAt vertexAt) {
+			const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+			for (uint64_t slotIdx = hash & mask;; slotIdx = (slotIdx + 1) & mask) {
+				Slot& slot = slots[slotIdx];
+				if (slot.vertex == EMPTY) {
+					slot = Slot{ tag, newVertex };
+					return newVertex;
+				}
+				if (slot.tag == tag && std::memcmp(&vertexAt(slot.vertex), &candidate, sizeof(Vertex)) == 0) return slot.vertex;
+			}
+		}
+	};
+
+	uint32_t weldSerial(Vertex* vertices, uint32_t count, Index* indicesOut) {
+		WeldTable table(count);
+		uint32_t numUnique = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			const Vertex vertex = vertices[i];
+			//entries are output indices, so they point at where unique vertices were moved to, which nothing overwrites
+			uint32_t unique = table.findOrInsert(hashVertex(vertex), vertex, numUnique, [&](uint32_t idx) -> const Vertex& { return vertices[idx]; });
+			if (unique == numUnique) {
+				if (numUnique == WELD_MAX_UNIQUE) return WELD_MAX_UNIQUE + 1;
+				vertices[numUnique++] = vertex;
+			}
+			indicesOut[i] = static_cast<Index>(unique);
+		}
+		return numUnique;
+	}
+
+	uint32_t weldParallel(Vertex* vertices, uint32_t count, Index* indicesOut, size_t numThreads) {
+		//hashes pick the partition and are reused for the table lookups
+		std::vector<uint64_t> hashes(count);
+		const size_t hashChunk = WELD_PARALLEL_MIN_VERTICES;
+		parallelFor((count + hashChunk - 1) / hashChunk, numThreads, [&](size_t chunkIdx) {
+			const uint32_t end = static_cast<uint32_t>(std::min<size_t>(count, (chunkIdx + 1) * hashChunk));
+			for (uint32_t i = static_cast<uint32_t>(chunkIdx * hashChunk); i < end; i++) hashes[i] = hashVertex(vertices[i]);
+			});
+
+		//stable counting sort into partitions, so each partition sees its vertices in input order
+		const size_t numPartitions = numThreads;
+		auto partitionOf = [&](uint64_t hash) { return static_cast<size_t>((hash >> 32) % numPartitions); };
+		std::vector<uint32_t> partitionStart(numPartitions + 1, 0);
+		for (uint32_t i = 0; i < count; i++) partitionStart[partitionOf(hashes[i]) + 1]++;
+		for (size_t partition = 0; partition < numPartitions; partition++) partitionStart[partition + 1] += partitionStart[partition];
+		std::vector<uint32_t> order(count);
+		{
+			std::vector<uint32_t> next(partitionStart.begin(), partitionStart.end() - 1);
+			for (uint32_t i = 0; i < count; i++) order[next[partitionOf(hashes[i])]++] = i;
+		}
+
+		//first[i] is the input idx of the first vertex equal to vertex i, entries are input idxs since nothing moves yet
+		std::vector<uint32_t> first(count);
+		parallelFor(numPartitions, numThreads, [&](size_t partition) {
+			const uint32_t begin = partitionStart[partition], end = partitionStart[partition + 1];
+			WeldTable table(end - begin);
+			for (uint32_t orderIdx = begin; orderIdx < end; orderIdx++) {
+				const uint32_t i = order[orderIdx];
+				first[i] = table.findOrInsert(hashes[i], vertices[i], i, [&](uint32_t idx) -> const Vertex& { return vertices[idx]; });
+			}
+			});
+
+		//compact in input order, first[] of a unique vertex is replaced by its output idx once it is moved
+		//duplicates only ever read first[] of an earlier unique vertex, so one array does both
+		uint32_t numUnique = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			if (first[i] == i) {
+				if (numUnique == WELD_MAX_UNIQUE) return WELD_MAX_UNIQUE + 1;
+				vertices[numUnique] = vertices[i];
+				first[i] = numUnique++;
+				indicesOut[i] = static_cast<Index>(first[i]);
+			}
+			else indicesOut[i] = static_cast<Index>(first[first[i]]);
+		}
+		return numUnique;
+	}
+}
+
+uint64_t hashVertex(const Vertex& vertex) {
+	VertexChunks chunks;
+	loadChunks(vertex, chunks);
+	//each 16 byte chunk is two 64 bit lanes, every 32 bit word is multiplied up into its lane, and the running
+	//lanes are rotated between chunks so the order of chunks matters
+#if defined(VERTEX_WELD_SSE2)
+	const __m128i k1 = _mm_set1_epi32(static_cast<int>(HASH_K1));
+	const __m128i k2 = _mm_set1_epi32(static_cast<int>(HASH_K2));
+	__m128i lanes = _mm_setzero_si128();
+	for (uint32_t chunkIdx = 0; chunkIdx < NUM_CHUNKS; chunkIdx++) {
+		const __m128i chunk = _mm_load_si128(reinterpret_cast<const __m128i*>(chunks.bytes + chunkIdx * 16));
+		const __m128i mixed = _mm_add_epi64(_mm_mul_epu32(chunk, k1), _mm_mul_epu32(_mm_srli_epi64(chunk, 32), k2));
+		lanes = _mm_or_si128(_mm_slli_epi64(lanes, HASH_ROTATE), _mm_srli_epi64(lanes, 64 - HASH_ROTATE));
+		lanes = _mm_xor_si128(lanes, mixed);
+	}
+	alignas(16) uint64_t lane[2];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lane), lanes);
+#else
+	uint64_t lane[2] = { 0, 0 };
+	for (uint32_t chunkIdx = 0; chunkIdx < NUM_CHUNKS; chunkIdx++) {
+		uint32_t word[4];
+		std::memcpy(word, chunks.bytes + chunkIdx * 16, 16);
+		for (int l = 0; l < 2; l++) {
+			const uint64_t mixed = static_cast<uint64_t>(word[l * 2]) * HASH_K1 + static_cast<uint64_t>(word[l * 2 + 1]) * HASH_K2;
+			lane[l] = ((lane[l] << HASH_ROTATE) | (lane[l] >> (64 - HASH_ROTATE))) ^ mixed;
+		}
+	}
+#endif
+	return finalizeHash(lane[0] ^ ((lane[1] << 32) | (lane[1] >> 32)) ^ sizeof(Vertex));
+}
+
+uint32_t weldVertices(Vertex* vertices, uint32_t count, Index* indicesOut, size_t numThreads) {
+	if (numThreads <= 1 || count < WELD_PARALLEL_MIN_VERTICES) return weldSerial(vertices, count, indicesOut);
+	return weldParallel(vertices, count, indicesOut, numThreads);
+}
@@ -935,7 +935,7 @@ void App::createGraphicsPipeline(const Mode& mode) {
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     VkPipelineRasterizationStateCreateInfo rasterizer{};
     VkGraphicsPipelineCreateInfo pipelineInfo{};
-    VkVertexInputBindingDescription bindingDescription{};
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
     VkPipelineDepthStencilStateCreateInfo depthStencil{};
     std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 
@@ -966,21 +966,25 @@ void App::createGraphicsPipeline(const Mode& mode) {
         }
 
         //vertexInput
-        bindingDescription = getVertexBindingDescription();
-        attributeDescriptions = getVertexAttributeDescriptions();
+        //shadow map vertex shaders only read the position (location 0), with split positions they bind just that stream
+        const bool positionsOnly = stage.type == SHADOWMAP;
+        bindingDescriptions = getVertexBindingDescriptions(positionsOnly);
+        attributeDescriptions = getVertexAttributeDescriptions(positionsOnly);
 
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
         vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+        vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
         vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
         //inputAssembly
         inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         static bool stripify = mode.modeParameters.STRIPIFY; 
-        inputAssembly.primitiveRestartEnable = ((stripify && (stage.type == MAIN_RENDER)) || (stage.type == DEBUG_DRAW)) ? VK_TRUE : VK_FALSE;
-        if (stripify && stage.type == MAIN_RENDER)  inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP; //restart index is 0xFFFFFFFF
-        else if (stage.type == DEBUG_DRAW) inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP; //like tri strip, restart is 0xFFFFFFFF
+        //with stripify every stage that draws meshes reads the strips written by stripify (see Mesh::loadMeshData)
+        const bool meshStrips = stripify && (stage.type == MAIN_RENDER || stage.type == SHADOWMAP);
+        inputAssembly.primitiveRestartEnable = (meshStrips || (stage.type == DEBUG_DRAW)) ? VK_TRUE : VK_FALSE;
+        if (meshStrips)  inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP; //restart index is PRIMITIVE_RESTART_IDX, the max of Index
+        else if (stage.type == DEBUG_DRAW) inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP; //like tri strip, restart is PRIMITIVE_RESTART_IDX
         else inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
         //rasterizer
@@ -1358,6 +1362,7 @@ void App::initProgram(Mode& mode) {
     createVertexBuffer();
     createIndexBuffer();
 #endif
+    if (!retainVertexIndexData) releaseVertexIndexData();
     createUniformBuffers(mode);
     createDepthResources();
     if (!useDynamicRendering) {